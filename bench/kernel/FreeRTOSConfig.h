@@ -0,0 +1,41 @@
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+/* Host configuration of the kernel sources built in the benches, as close to
+include/FreeRTOSConfig.h as the host allows.  configUSE_TIMER_WHEEL is given on
+the command line. */
+
+#define configUSE_PREEMPTION			1
+#define configUSE_IDLE_HOOK				0
+#define configUSE_TICK_HOOK				0
+#define configTICK_RATE_HZ				( ( TickType_t ) 1024 )
+#define configMAX_PRIORITIES			( 5 )
+#define configMAX_TASK_NAME_LEN			( 10 )
+#define configUSE_MUTEXES				1
+#define configQUEUE_REGISTRY_SIZE		0
+#define configUSE_16_BIT_TICKS			1
+#define configMINIMAL_STACK_SIZE		( ( unsigned short ) 90 )
+
+#define configUSE_CO_ROUTINES 			0
+
+#define configUSE_TIMERS				1
+#define configTIMER_TASK_PRIORITY		( 3 )
+#define configTIMER_QUEUE_LENGTH		10
+#define configTIMER_TASK_STACK_DEPTH	( configMINIMAL_STACK_SIZE )
+
+#ifndef configUSE_TIMER_WHEEL
+	#define configUSE_TIMER_WHEEL		0
+#endif
+
+#define INCLUDE_vTaskPrioritySet		0
+#define INCLUDE_uxTaskPriorityGet		0
+#define INCLUDE_vTaskDelete				0
+#define INCLUDE_vTaskSuspend			0
+#define INCLUDE_vTaskDelayUntil			0
+#define INCLUDE_vTaskDelay				0
+#define INCLUDE_xTaskGetSchedulerState	1
+
+#define configASSERT( x ) if( ( x ) == 0 ) { vBenchAssert( __FILE__, __LINE__ ); }
+void vBenchAssert( const char *pcFile, int iLine );
+
+#endif /* FREERTOS_CONFIG_H */
@@ -0,0 +1,266 @@
+/*******************************************************************************
+ * Host checks and microbenchmarks of src/hal/soft_timer.c
+ *
+ * TimerA0 is simulated: TA0R is a 16 bit counter advanced straight to the
+ * compare value of SOFT_TIMER_SLOT, whose callback is then called as the ISR
+ * would. The times are host nanoseconds, only their growth with the number
+ * of timers carries over to the MSP430.
+ ******************************************************************************/
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "soft_timer.h"
+
+
+#define BENCH_INSERTS       ( 100000 )
+#define BENCH_EXPIRIES      ( 100000 )
+#define BENCH_TIMERS_MAX    ( 64 )
+
+// Simulated TimerA0: counter, compare register of SOFT_TIMER_SLOT and the
+// ticks elapsed since the start of the run
+static uint16_t bench_ta0r;
+static uint16_t bench_ccr;
+static void (*bench_isr)(void);
+static unsigned long bench_elapsed;
+
+// Interrupts of SOFT_TIMER_SLOT and expiries seen by the callbacks
+static unsigned long bench_interrupts;
+static unsigned long bench_expiries;
+static unsigned long bench_expired_at;
+
+static soft_timer_t bench_timers[BENCH_TIMERS_MAX];
+
+
+unsigned int hal_timer_count( unsigned char timer )
+{
+    (void) timer;
+    return bench_ta0r;
+}
+
+void hal_timer_register_at_from_isr( unsigned char timer, unsigned char id, unsigned int time, void (*callback) (void) )
+{
+    (void) timer;
+    (void) id;
+    bench_ccr = time;
+    bench_isr = callback;
+}
+
+void hal_timer_unregister( unsigned char timer, unsigned char id )
+{
+    (void) timer;
+    (void) id;
+    bench_isr = NULL;
+}
+
+static void bench_callback( soft_timer_t *timer )
+{
+    (void) timer;
+    bench_expiries++;
+    bench_expired_at = bench_elapsed;
+}
+
+static uint64_t bench_ns( void )
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static void bench_reset( void )
+{
+    unsigned int i;
+
+    for (i = 0; i < BENCH_TIMERS_MAX; i++)
+        hal_soft_timer_stop(&bench_timers[i]);
+
+    for (i = 0; i < BENCH_TIMERS_MAX; i++)
+        hal_soft_timer_set_slack(&bench_timers[i], 0);
+
+    bench_ta0r = (uint16_t) rand();
+    bench_elapsed = 0;
+    bench_interrupts = 0;
+    bench_expiries = 0;
+}
+
+/*******************************************************************************
+ * \brief   Run the simulated TimerA0 until a number of ticks elapsed
+ *
+ * \param unsigned long     Number of ticks
+ * \return void
+ ******************************************************************************/
+static void bench_run( unsigned long ticks )
+{
+    unsigned long end = bench_elapsed + ticks;
+    unsigned long step;
+
+    while (bench_isr) {
+        // The counter reaches the compare value, after a whole wrap if it
+        // is already there
+        step = (uint16_t) (bench_ccr - bench_ta0r);
+        if (step == 0) step = 0x10000;
+        if (bench_elapsed + step > end) break;
+
+        bench_elapsed += step;
+        bench_ta0r = bench_ccr;
+        bench_interrupts++;
+        bench_isr();
+
+        // The ISR exits on the next count at the earliest
+        if (bench_isr && bench_ccr == bench_ta0r) {
+            bench_ta0r++;
+            bench_elapsed++;
+        }
+    }
+
+    bench_ta0r += end - bench_elapsed;
+    bench_elapsed = end;
+}
+
+/*******************************************************************************
+ * \brief   Check the expiries of a few known timers
+ *
+ * \param void
+ * \return int      Number of failed checks
+ ******************************************************************************/
+static int bench_check( void )
+{
+    int failed = 0;
+
+    // A one-shot expires once, at its deadline
+    bench_reset();
+    hal_soft_timer_start(&bench_timers[0], 10, 0, bench_callback);
+    bench_run(1000);
+    if (bench_expiries != 1 || bench_expired_at != 10 || bench_interrupts != 1) {
+        printf("FAIL one-shot: %lu expiries, last at %lu, %lu interrupts\n",
+               bench_expiries, bench_expired_at, bench_interrupts);
+        failed++;
+    }
+
+    // A periodic timer does not drift
+    bench_reset();
+    hal_soft_timer_start(&bench_timers[0], 100, 100, bench_callback);
+    bench_run(1000);
+    if (bench_expiries != 10 || bench_expired_at != 1000 || bench_interrupts != 10) {
+        printf("FAIL periodic: %lu expiries, last at %lu, %lu interrupts\n",
+               bench_expiries, bench_expired_at, bench_interrupts);
+        failed++;
+    }
+
+    // Overlapping slack windows share one interrupt
+    bench_reset();
+    hal_soft_timer_set_slack(&bench_timers[0], 10);
+    hal_soft_timer_start(&bench_timers[0], 100, 0, bench_callback);
+    hal_soft_timer_start(&bench_timers[1], 105, 0, bench_callback);
+    bench_run(1000);
+    if (bench_expiries != 2 || bench_interrupts != 1) {
+        printf("FAIL slack: %lu expiries, %lu interrupts\n", bench_expiries, bench_interrupts);
+        failed++;
+    }
+
+    // The longest timeout with the largest slack still needs one interrupt
+    bench_reset();
+    hal_soft_timer_set_slack(&bench_timers[0], SOFT_TIMER_MAX_TICKS);
+    hal_soft_timer_start(&bench_timers[0], SOFT_TIMER_MAX_TICKS, 0, bench_callback);
+    bench_run(0x20000);
+    if (bench_expiries != 1 || bench_expired_at != SOFT_TIMER_MAX_TICKS || bench_interrupts != 1) {
+        printf("FAIL largest slack: %lu expiries, last at %lu, %lu interrupts\n",
+               bench_expiries, bench_expired_at, bench_interrupts);
+        failed++;
+    }
+
+    // Same for a periodic timer, whose slack must not delay it by a period
+    bench_reset();
+    hal_soft_timer_set_slack(&bench_timers[0], SOFT_TIMER_MAX_TICKS);
+    hal_soft_timer_start(&bench_timers[0], SOFT_TIMER_MAX_TICKS, SOFT_TIMER_MAX_TICKS, bench_callback);
+    bench_run(4 * SOFT_TIMER_MAX_TICKS);
+    if (bench_expiries != 4 || bench_interrupts != 4) {
+        printf("FAIL largest periodic slack: %lu expiries, %lu interrupts\n",
+               bench_expiries, bench_interrupts);
+        failed++;
+    }
+
+    return failed;
+}
+
+/*******************************************************************************
+ * \brief   Time the start of a timer with n - 1 others pending
+ *
+ * \param unsigned int      Number of timers
+ * \return double           Nanoseconds per hal_soft_timer_start()
+ ******************************************************************************/
+static double bench_insert( unsigned int n )
+{
+    unsigned int i;
+    uint64_t start;
+
+    bench_reset();
+    for (i = 0; i < n; i++)
+        hal_soft_timer_start(&bench_timers[i], 1 + rand() % 0x4000, 0, bench_callback);
+
+    start = bench_ns();
+    for (i = 0; i < BENCH_INSERTS; i++)
+        hal_soft_timer_start(&bench_timers[i % n], 1 + rand() % 0x4000, 0, bench_callback);
+
+    return (double) (bench_ns() - start) / BENCH_INSERTS;
+}
+
+/*******************************************************************************
+ * \brief   Time the expiries of n periodic timers
+ *
+ * \param unsigned int      Number of timers
+ * \param unsigned long *   Set to the most expiries handled by an interrupt
+ * \return double           Nanoseconds per expiry
+ ******************************************************************************/
+static double bench_expire( unsigned int n, unsigned long *most )
+{
+    unsigned int i;
+    unsigned long before;
+    uint64_t start, total = 0;
+
+    *most = 0;
+
+    bench_reset();
+    for (i = 0; i < n; i++)
+        hal_soft_timer_start(&bench_timers[i], 1 + rand() % 1024, 64 + rand() % 1024, bench_callback);
+
+    while (bench_expiries < BENCH_EXPIRIES) {
+        bench_elapsed += (uint16_t) (bench_ccr - bench_ta0r);
+        bench_ta0r = bench_ccr;
+
+        before = bench_expiries;
+        start = bench_ns();
+        bench_isr();
+        total += bench_ns() - start;
+
+        if (bench_expiries - before > *most) *most = bench_expiries - before;
+        if (bench_ccr == bench_ta0r) bench_ta0r++;
+    }
+
+    return (double) total / bench_expiries;
+}
+
+int main( void )
+{
+    unsigned int n;
+    double insert, expire;
+    unsigned long most;
+    int failed;
+
+    srand(1);
+
+    failed = bench_check();
+    printf("checks: %s\n\n", failed ? "FAILED" : "passed");
+
+    printf("timers  ns/insert  ns/expiry  most expiries/interrupt\n");
+    for (n = 1; n <= BENCH_TIMERS_MAX; n *= 2) {
+        insert = bench_insert(n);
+        expire = bench_expire(n, &most);
+        printf("%6u  %9.1f  %9.1f  %23lu\n", n, insert, expire, most);
+    }
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,19 @@
+#ifndef BENCH_FREERTOS_H
+#define BENCH_FREERTOS_H
+
+#include <stddef.h>
+
+// Host stand-in for the kernel and MSP430 headers included by the HAL
+// sources built in the benches. The CPU never has its interrupts disabled.
+
+#define GIE                         ( 0x0008 )
+
+#define __get_SR_register()         ( GIE )
+#define __bis_SR_register(_bits)    ( (void) (_bits) )
+#define __disable_interrupt()       do { } while (0)
+#define __nop()                     do { } while (0)
+
+// Drops the vector from __attribute__ ( ( interrupt(vector) ) )
+#define interrupt(_vector)
+
+#endif /* BENCH_FREERTOS_H */
@@ -0,0 +1,6 @@
+#ifndef BENCH_CONFIG_H
+#define BENCH_CONFIG_H
+
+// The HAL sources built in the benches need no option
+
+#endif /* BENCH_CONFIG_H */
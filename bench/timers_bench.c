@@ -0,0 +1,396 @@
+/*******************************************************************************
+ * Host checks and microbenchmarks of freertos/timers.c
+ *
+ * Built twice, with configUSE_TIMER_WHEEL set to 1 and to 0, to compare the
+ * timing wheel with the sorted timer lists. The timer service task is run by
+ * hand: the kernel functions it calls are stubbed, the tick count jumps to the
+ * end of each of its waits and the timer queue is a plain ring. The times are
+ * host nanoseconds, only their growth with the number of timers carries over
+ * to the MSP430.
+ ******************************************************************************/
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// The static functions of the timer service are driven directly
+#include "../freertos/timers.c"
+
+
+#define BENCH_INSERTS       ( 100000 )
+#define BENCH_EXPIRIES      ( 100000 )
+#define BENCH_TIMERS_MAX    ( 1000 )
+#define BENCH_QUEUE_LENGTH  ( 1024 )
+
+// Simulated tick count and the ticks elapsed since the start of the run
+static TickType_t bench_tick;
+static unsigned long bench_elapsed;
+
+// Timer queue ring, and the wait of the timer service task when it blocks
+static DaemonTaskMessage_t bench_queue[BENCH_QUEUE_LENGTH];
+static unsigned int bench_queue_head;
+static unsigned int bench_queue_tail;
+static int bench_blocked;
+static TickType_t bench_wait;
+
+// Expiries seen by the callbacks, and those not at the expected tick
+static unsigned long bench_expiries;
+static unsigned long bench_late;
+
+static TimerHandle_t bench_timers[BENCH_TIMERS_MAX];
+static unsigned long bench_expected[BENCH_TIMERS_MAX];
+
+
+void vBenchAssert( const char *pcFile, int iLine )
+{
+    printf("assert failed at %s:%d\n", pcFile, iLine);
+    exit(1);
+}
+
+TickType_t xTaskGetTickCount( void )
+{
+    return bench_tick;
+}
+
+BaseType_t xTaskGetSchedulerState( void )
+{
+    return taskSCHEDULER_RUNNING;
+}
+
+void vTaskSuspendAll( void )
+{
+}
+
+BaseType_t xTaskResumeAll( void )
+{
+    return pdFALSE;
+}
+
+BaseType_t xTaskGenericCreate( TaskFunction_t pxTaskCode, const char * const pcName, const uint16_t usStackDepth, void * const pvParameters, UBaseType_t uxPriority, TaskHandle_t * const pxCreatedTask, StackType_t * const puxStackBuffer, const MemoryRegion_t * const xRegions )
+{
+    (void) pxTaskCode;
+    (void) pcName;
+    (void) usStackDepth;
+    (void) pvParameters;
+    (void) uxPriority;
+    (void) pxCreatedTask;
+    (void) puxStackBuffer;
+    (void) xRegions;
+    return pdFAIL;
+}
+
+void *pvPortMalloc( size_t xSize )
+{
+    return malloc(xSize);
+}
+
+void vPortFree( void *pv )
+{
+    free(pv);
+}
+
+QueueHandle_t xQueueGenericCreate( const UBaseType_t uxQueueLength, const UBaseType_t uxItemSize, const uint8_t ucQueueType )
+{
+    (void) uxQueueLength;
+    (void) ucQueueType;
+    configASSERT( uxItemSize == sizeof(DaemonTaskMessage_t) );
+    return (QueueHandle_t) bench_queue;
+}
+
+BaseType_t xQueueGenericSend( QueueHandle_t xQueue, const void * const pvItemToQueue, TickType_t xTicksToWait, const BaseType_t xCopyPosition )
+{
+    unsigned int next = (bench_queue_head + 1) % BENCH_QUEUE_LENGTH;
+
+    (void) xQueue;
+    (void) xTicksToWait;
+    (void) xCopyPosition;
+
+    if (next == bench_queue_tail) return errQUEUE_FULL;
+
+    memcpy(&bench_queue[bench_queue_head], pvItemToQueue, sizeof(DaemonTaskMessage_t));
+    bench_queue_head = next;
+    return pdPASS;
+}
+
+BaseType_t xQueueGenericSendFromISR( QueueHandle_t xQueue, const void * const pvItemToQueue, BaseType_t * const pxHigherPriorityTaskWoken, const BaseType_t xCopyPosition )
+{
+    (void) pxHigherPriorityTaskWoken;
+    return xQueueGenericSend(xQueue, pvItemToQueue, 0, xCopyPosition);
+}
+
+BaseType_t xQueueGenericReceive( QueueHandle_t xQueue, void * const pvBuffer, TickType_t xTicksToWait, const BaseType_t xJustPeek )
+{
+    (void) xQueue;
+    (void) xTicksToWait;
+    (void) xJustPeek;
+
+    if (bench_queue_tail == bench_queue_head) return errQUEUE_EMPTY;
+
+    memcpy(pvBuffer, &bench_queue[bench_queue_tail], sizeof(DaemonTaskMessage_t));
+    bench_queue_tail = (bench_queue_tail + 1) % BENCH_QUEUE_LENGTH;
+    return pdPASS;
+}
+
+void vQueueWaitForMessageRestricted( QueueHandle_t xQueue, TickType_t xTicksToWait )
+{
+    (void) xQueue;
+
+    // The task only blocks with nothing left to receive
+    if (bench_queue_tail != bench_queue_head) return;
+
+    bench_blocked = 1;
+    bench_wait = xTicksToWait;
+}
+
+static void bench_callback( TimerHandle_t xTimer )
+{
+    unsigned int i = (unsigned int) (uintptr_t) pvTimerGetTimerID(xTimer);
+    Timer_t *pxTimer = (Timer_t *) xTimer;
+
+    bench_expiries++;
+    if (bench_elapsed != bench_expected[i]) bench_late++;
+
+    bench_expected[i] += pxTimer->xTimerPeriodInTicks;
+}
+
+static uint64_t bench_ns( void )
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+/*******************************************************************************
+ * \brief   Run the timer service task until it blocks
+ *
+ *          Same steps as prvTimerTask(), it blocks when it waits with an
+ *          empty timer queue.
+ *
+ * \param void
+ * \return void
+ ******************************************************************************/
+static void bench_service( void )
+{
+    TickType_t xNextExpireTime;
+    BaseType_t xListWasEmpty;
+
+    bench_blocked = 0;
+    while (!bench_blocked) {
+        xNextExpireTime = prvGetNextExpireTime(&xListWasEmpty);
+        prvProcessTimerOrBlockTask(xNextExpireTime, xListWasEmpty);
+        prvProcessReceivedCommands();
+    }
+}
+
+/*******************************************************************************
+ * \brief   Run the timer service task until a number of ticks elapsed
+ *
+ * \param unsigned long     Number of ticks
+ * \return void
+ ******************************************************************************/
+static void bench_run( unsigned long ticks )
+{
+    unsigned long end = bench_elapsed + ticks;
+    unsigned long step;
+
+    bench_service();
+    while (bench_elapsed < end) {
+        // A wait of 0 ticks makes the task yield until the next tick
+        step = bench_wait ? bench_wait : 1;
+        if (step > end - bench_elapsed) step = end - bench_elapsed;
+
+        bench_tick += (TickType_t) step;
+        bench_elapsed += step;
+        bench_service();
+    }
+}
+
+/*******************************************************************************
+ * \brief   Start a timer now, through the timer queue
+ *
+ * \param unsigned int      Index of the timer
+ * \param TickType_t        Period
+ * \param UBaseType_t       pdTRUE for an auto reload timer
+ * \return void
+ ******************************************************************************/
+static void bench_start( unsigned int i, TickType_t period, UBaseType_t reload )
+{
+    Timer_t *pxTimer = (Timer_t *) bench_timers[i];
+
+    pxTimer->xTimerPeriodInTicks = period;
+    pxTimer->uxAutoReload = reload;
+    bench_expected[i] = bench_elapsed + period;
+
+    configASSERT( xTimerStart(bench_timers[i], 0) == pdPASS );
+}
+
+static void bench_reset( TickType_t tick )
+{
+    unsigned int i;
+
+    for (i = 0; i < BENCH_TIMERS_MAX; i++)
+        configASSERT( xTimerStop(bench_timers[i], 0) == pdPASS );
+
+    bench_service();
+
+    // The wheel has to catch up with the tick count, it never runs backwards
+    while (bench_tick != tick) {
+        bench_tick++;
+        bench_service();
+    }
+
+    bench_elapsed = 0;
+    bench_expiries = 0;
+    bench_late = 0;
+}
+
+/*******************************************************************************
+ * \brief   Check the expiries of a few known timers
+ *
+ * \param void
+ * \return int      Number of failed checks
+ ******************************************************************************/
+static int bench_check( void )
+{
+    unsigned int i;
+    unsigned long expected;
+    int failed = 0;
+
+    // A one-shot expires once, at its deadline
+    bench_reset(0);
+    bench_start(0, 10, pdFALSE);
+    bench_run(1000);
+    if (bench_expiries != 1 || bench_late) {
+        printf("FAIL one-shot: %lu expiries, %lu late\n", bench_expiries, bench_late);
+        failed++;
+    }
+
+    // An auto reload timer does not drift
+    bench_reset(0);
+    bench_start(0, 7, pdTRUE);
+    bench_run(1000);
+    if (bench_expiries != 1000 / 7 || bench_late) {
+        printf("FAIL auto reload: %lu expiries, %lu late\n", bench_expiries, bench_late);
+        failed++;
+    }
+
+    // Timers expiring on both sides of the tick count overflow
+    bench_reset(0xff00);
+    bench_start(0, 0x80, pdFALSE);
+    bench_start(1, 0x100, pdFALSE);
+    bench_start(2, 0x180, pdFALSE);
+    bench_start(3, 0x33, pdTRUE);
+    bench_run(0x400);
+    if (bench_expiries != 3 + 0x400 / 0x33 || bench_late) {
+        printf("FAIL overflow: %lu expiries, %lu late\n", bench_expiries, bench_late);
+        failed++;
+    }
+
+    // Many timers with random periods, across several overflows
+    bench_reset((TickType_t) rand());
+    expected = 0;
+    for (i = 0; i < BENCH_TIMERS_MAX; i++) {
+        bench_start(i, 1 + rand() % 0x7fff, (i & 1) ? pdTRUE : pdFALSE);
+        expected += (i & 1) ? 0x40000 / ((Timer_t *) bench_timers[i])->xTimerPeriodInTicks : 1;
+    }
+    bench_run(0x40000);
+    if (bench_expiries != expected || bench_late) {
+        printf("FAIL random: %lu expiries out of %lu, %lu late\n", bench_expiries, expected, bench_late);
+        failed++;
+    }
+
+    return failed;
+}
+
+/*******************************************************************************
+ * \brief   Time the restart of a timer with n - 1 others active
+ *
+ *          Times what the timer service task does for tmrCOMMAND_RESET.
+ *
+ * \param unsigned int      Number of timers
+ * \return double           Nanoseconds per restart
+ ******************************************************************************/
+static double bench_insert( unsigned int n )
+{
+    unsigned int i;
+    Timer_t *pxTimer;
+    BaseType_t xTimerListsWereSwitched;
+    TickType_t xTimeNow;
+    uint64_t start;
+
+    bench_reset(bench_tick);
+    for (i = 0; i < n; i++)
+        bench_start(i, 1 + rand() % 0x4000, pdFALSE);
+    bench_service();
+
+    start = bench_ns();
+    for (i = 0; i < BENCH_INSERTS; i++) {
+        pxTimer = (Timer_t *) bench_timers[i % n];
+        xTimeNow = prvSampleTimeNow(&xTimerListsWereSwitched);
+
+        if (listIS_CONTAINED_WITHIN(NULL, &(pxTimer->xTimerListItem)) == pdFALSE)
+            prvRemoveTimerFromActiveList(pxTimer);
+
+        pxTimer->xTimerPeriodInTicks = 1 + rand() % 0x4000;
+        prvInsertTimerInActiveList(pxTimer, xTimeNow + pxTimer->xTimerPeriodInTicks, xTimeNow, xTimeNow);
+    }
+
+    return (double) (bench_ns() - start) / BENCH_INSERTS;
+}
+
+/*******************************************************************************
+ * \brief   Time the expiries of n auto reload timers
+ *
+ * \param unsigned int      Number of timers
+ * \return double           Nanoseconds per expiry
+ ******************************************************************************/
+static double bench_expire( unsigned int n )
+{
+    unsigned int i;
+    uint64_t start, total = 0;
+
+    bench_reset(bench_tick);
+    for (i = 0; i < n; i++)
+        bench_start(i, 64 + rand() % 1024, pdTRUE);
+    bench_service();
+
+    while (bench_expiries < BENCH_EXPIRIES) {
+        bench_tick += bench_wait;
+        bench_elapsed += bench_wait;
+
+        start = bench_ns();
+        bench_service();
+        total += bench_ns() - start;
+    }
+
+    return (double) total / bench_expiries;
+}
+
+int main( void )
+{
+    static const unsigned int counts[] = { 10, 100, 1000 };
+    unsigned int i;
+    double insert, expire;
+    int failed;
+
+    srand(1);
+
+    for (i = 0; i < BENCH_TIMERS_MAX; i++)
+        bench_timers[i] = xTimerCreate("Bench", 1, pdFALSE, (void *) (uintptr_t) i, bench_callback);
+
+    printf("%s\n", configUSE_TIMER_WHEEL ? "timer wheel" : "timer lists");
+
+    failed = bench_check();
+    printf("checks: %s\n\n", failed ? "FAILED" : "passed");
+
+    printf("timers  ns/insert  ns/expiry\n");
+    for (i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+        insert = bench_insert(counts[i]);
+        expire = bench_expire(counts[i]);
+        printf("%6u  %9.1f  %9.1f\n", counts[i], insert, expire);
+    }
+
+    return failed ? 1 : 0;
+}
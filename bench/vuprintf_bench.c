@@ -0,0 +1,151 @@
+/*******************************************************************************
+ * Host microbenchmark of src/utils/vuprintf.c
+ *
+ * Compares the formatter of the baseline tree (bench/baseline/vuprintf.c,
+ * unbounded, into a buffer) with the current one: the same unbounded call,
+ * the bounded vsnuprintf(), and the sink path slog() takes, into a ring as
+ * the UART transmit ring, with the format parsed at runtime and with a
+ * UPRINTF_PLAN(), once and twice as slog() does to count the characters
+ * first. The costs are host TSC cycles per output character. The
+ * MSP430 converts the integers with DADD, the host with the table of the
+ * baseline, so only the costs of the other formatting steps carry over.
+ ******************************************************************************/
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <x86intrin.h>
+
+#include "vuprintf.h"
+
+
+#define BENCH_LOOPS         ( 200000 )
+#define BENCH_RING_SIZE     ( 512 )
+
+void vuprintf_baseline(char *str, const char *format, va_list a);
+
+// Output of the buffer formatters, and ring of the sink ones
+static char bench_buf[256];
+static char bench_ring[BENCH_RING_SIZE];
+static unsigned int bench_pos;
+
+// Argument of the %s case
+#define BENCH_STR   "0123456789abcdefghijklmnopqrstuvwxyzABCD"
+
+typedef enum {
+    BENCH_BASELINE,
+    BENCH_VUPRINTF,
+    BENCH_VSNUPRINTF,
+    BENCH_SINK,
+    BENCH_PLAN,
+    BENCH_TWO_PASS,
+    BENCH_KINDS
+} bench_kind_t;
+
+static const char *bench_names[BENCH_KINDS] = {
+    "baseline", "vuprintf", "vsnuprintf", "sink", "plan sink", "2 passes",
+};
+
+
+static void bench_put( void *ctx, char c )
+{
+    (void) ctx;
+    bench_ring[bench_pos++ & (BENCH_RING_SIZE - 1)] = c;
+}
+
+static void bench_skip( void *ctx, char c )
+{
+    (void) ctx;
+    (void) c;
+}
+
+static unsigned int bench_call( bench_kind_t kind, const char *fmt, const uprintf_plan_t *plan, ... )
+{
+    unsigned int len = 0;
+    va_list va, count;
+    va_start(va, plan);
+
+    switch (kind) {
+        case BENCH_BASELINE:
+            vuprintf_baseline(bench_buf, fmt, va);
+            break;
+        case BENCH_VUPRINTF:
+            vuprintf(bench_buf, fmt, va);
+            break;
+        case BENCH_VSNUPRINTF:
+            len = vsnuprintf(bench_buf, sizeof(bench_buf), fmt, va);
+            break;
+        case BENCH_SINK:
+            len = vuprintf_sink(bench_put, NULL, 80, fmt, va);
+            break;
+        case BENCH_PLAN:
+            len = vuprintf_plan_sink(bench_put, NULL, 80, plan, va);
+            break;
+        default:
+            va_copy(count, va);
+            len = vuprintf_plan_sink(bench_skip, NULL, 80, plan, count);
+            va_end(count);
+            vuprintf_plan_sink(bench_put, NULL, len, plan, va);
+            break;
+    }
+
+    va_end(va);
+
+    return len;
+}
+
+/*******************************************************************************
+ * \brief   Time a case with each formatter
+ *
+ *          Each case is a macro so that its plan is defined from its
+ *          arguments, the first call of each formatter checks the output
+ *          against the baseline.
+ ******************************************************************************/
+#define BENCH_CASE(_name, _fmt, ...) \
+    do { \
+        UPRINTF_PLAN(plan_, _fmt, __VA_ARGS__); \
+        char expected_[256]; \
+        unsigned int len_, kind_, i_; \
+        uint64_t start_; \
+        bench_call(BENCH_BASELINE, _fmt, &plan_, __VA_ARGS__); \
+        strcpy(expected_, bench_buf); \
+        len_ = strlen(expected_); \
+        printf("%-10s %5u", _name, len_); \
+        for (kind_ = 0; kind_ < BENCH_KINDS; kind_++) { \
+            bench_pos = 0; \
+            bench_call(kind_, _fmt, &plan_, __VA_ARGS__); \
+            if (kind_ >= BENCH_SINK) { \
+                memcpy(bench_buf, bench_ring, len_); \
+                bench_buf[len_] = 0; \
+            } \
+            if (strcmp(bench_buf, expected_)) { \
+                printf("\nFAIL %s: \"%s\" instead of \"%s\"\n", bench_names[kind_], bench_buf, expected_); \
+                failed++; \
+            } \
+            start_ = __rdtsc(); \
+            for (i_ = 0; i_ < BENCH_LOOPS; i_++) \
+                bench_call(kind_, _fmt, &plan_, __VA_ARGS__); \
+            printf("  %10.1f", (double) (__rdtsc() - start_) / BENCH_LOOPS / len_); \
+        } \
+        printf("\n"); \
+    } while (0)
+
+int main( void )
+{
+    unsigned int kind;
+    int failed = 0;
+
+    printf("TSC cycles per character\n\n");
+    printf("case         len");
+    for (kind = 0; kind < BENCH_KINDS; kind++) printf("  %10s", bench_names[kind]);
+    printf("\n");
+
+    BENCH_CASE("string", "%s", BENCH_STR);
+    BENCH_CASE("text", "the quick brown fox jumps over the lazy dog %c", 'x');
+    BENCH_CASE("words", "%u %u %i %u", 7u, 65535u, -1234, 42u);
+    BENCH_CASE("longs", "%n %l", 4000000000ul, -123456789l);
+    BENCH_CASE("hex", "%x %x %x", 0xbeefu, 0x0001u, 0xa5a5u);
+    BENCH_CASE("log line", "task %s prio %u stack %u free %n", "shell", 2u, 240u, 123456ul);
+
+    return failed ? 1 : 0;
+}
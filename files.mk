@@ -12,16 +12,24 @@ INCLUDES += -I. \
 
 SRCS = $(SOURCE_PATH)/main.c \
 	$(SOURCE_PATH)/log.c \
+	$(SOURCE_PATH)/shell.c \
+	$(SOURCE_PATH)/mux.c \
 	$(SOURCE_PATH)/hal/misc.c \
+	$(SOURCE_PATH)/hal/clock.c \
+	$(SOURCE_PATH)/hal/power.c \
 	$(SOURCE_PATH)/hal/uart.c \
 	$(SOURCE_PATH)/hal/timer.c \
+	$(SOURCE_PATH)/hal/soft_timer.c \
+	$(SOURCE_PATH)/hal/timestamp.c \
 	$(SOURCE_PATH)/hal/ti/ucs.c \
 	$(SOURCE_PATH)/hal/ti/pmm.c \
 	$(SOURCE_PATH)/utils/vuprintf.c \
+	$(SOURCE_PATH)/utils/crc16.c \
 	$(PORT_PATH)/port.c \
 	$(PORT_PATH)/portext.S \
 	$(FREERTOS_PATH)/tasks.c \
 	$(FREERTOS_PATH)/timers.c \
 	$(FREERTOS_PATH)/list.c \
 	$(FREERTOS_PATH)/queue.c \
-	$(FREERTOS_PATH)/portable/MemMang/heap_2.c
+	$(FREERTOS_PATH)/portable/MemMang/heap_2.c \
+	$(FREERTOS_PATH)/portable/MemMang/arena.c
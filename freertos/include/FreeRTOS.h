@@ -187,10 +187,18 @@ extern "C" {
 	#define INCLUDE_pcTaskGetTaskName 0
 #endif
 
+#ifndef INCLUDE_vTaskDelayWithSlack
+	#define INCLUDE_vTaskDelayWithSlack 0
+#endif
+
 #ifndef configUSE_APPLICATION_TASK_TAG
 	#define configUSE_APPLICATION_TASK_TAG 0
 #endif
 
+#ifndef configUSE_COMPACT_TCB
+	#define configUSE_COMPACT_TCB 0
+#endif
+
 #ifndef INCLUDE_uxTaskGetStackHighWaterMark
 	#define INCLUDE_uxTaskGetStackHighWaterMark 0
 #endif
@@ -211,6 +219,18 @@ extern "C" {
 	#define configUSE_TIMERS 0
 #endif
 
+#ifndef configUSE_TIMER_WHEEL
+	#define configUSE_TIMER_WHEEL 0
+#endif
+
+#ifndef configUSE_DELAYED_TASK_WHEEL
+	#define configUSE_DELAYED_TASK_WHEEL 0
+#endif
+
+#ifndef configDELAYED_TASK_WHEEL_SIZE
+	#define configDELAYED_TASK_WHEEL_SIZE 16
+#endif
+
 #ifndef configUSE_COUNTING_SEMAPHORES
 	#define configUSE_COUNTING_SEMAPHORES 0
 #endif
@@ -223,6 +243,10 @@ extern "C" {
 	#define portCRITICAL_NESTING_IN_TCB 0
 #endif
 
+#ifndef portTICK_TYPE_IS_ATOMIC
+	#define portTICK_TYPE_IS_ATOMIC 0
+#endif
+
 #ifndef configMAX_TASK_NAME_LEN
 	#define configMAX_TASK_NAME_LEN 16
 #endif
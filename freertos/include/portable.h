@@ -393,6 +393,31 @@ void vPortInitialiseBlocks( void ) PRIVILEGED_FUNCTION;
 size_t xPortGetFreeHeapSize( void ) PRIVILEGED_FUNCTION;
 size_t xPortGetMinimumEverFreeHeapSize( void ) PRIVILEGED_FUNCTION;
 
+/* Used by arena.c. */
+typedef struct ArenaDefinition
+{
+	uint8_t *pucBase;		/*< Start of the block carved from the heap. */
+	size_t xSize;			/*< Size of the block in bytes. */
+	size_t xUsed;			/*< Bump offset, in bytes, from pucBase. */
+	size_t xPeakUsed;		/*< Highest value xUsed ever reached. */
+} Arena_t;
+
+/*
+ * Per-task bump allocators built on top of pvPortMalloc().  An arena is a
+ * single block taken from the heap once, from which xPortArenaAlloc() hands
+ * out memory by moving a pointer forward.  Memory is never freed one
+ * allocation at a time - instead the owner records a mark with
+ * xPortArenaMark() and later releases everything allocated since that mark
+ * with vPortArenaReset().  An arena is not thread safe and must only be used
+ * by the task that owns it.
+ */
+BaseType_t xPortArenaCreate( Arena_t * const pxArena, size_t xSize ) PRIVILEGED_FUNCTION;
+void vPortArenaDelete( Arena_t * const pxArena ) PRIVILEGED_FUNCTION;
+void *pvPortArenaAlloc( Arena_t * const pxArena, size_t xWantedSize ) PRIVILEGED_FUNCTION;
+size_t xPortArenaMark( const Arena_t * const pxArena ) PRIVILEGED_FUNCTION;
+void vPortArenaReset( Arena_t * const pxArena, size_t xMark ) PRIVILEGED_FUNCTION;
+size_t xPortArenaGetPeakUsage( const Arena_t * const pxArena ) PRIVILEGED_FUNCTION;
+
 /*
  * Setup the hardware ready for the scheduler to take control.  This generally
  * sets up a tick interrupt and sets timers for the correct tick frequency.
@@ -159,6 +159,9 @@ typedef struct xTASK_STATUS
 	UBaseType_t uxBasePriority;		/* The priority to which the task will return if the task's current priority has been inherited to avoid unbounded priority inversion when obtaining a mutex.  Only valid if configUSE_MUTEXES is defined as 1 in FreeRTOSConfig.h. */
 	uint32_t ulRunTimeCounter;		/* The total run time allocated to the task so far, as defined by the run time stats clock.  See http://www.freertos.org/rtos-run-time-stats.html.  Only valid when configGENERATE_RUN_TIME_STATS is defined as 1 in FreeRTOSConfig.h. */
 	uint16_t usStackHighWaterMark;	/* The minimum amount of stack space that has remained for the task since the task was created.  The closer this value is to zero the closer the task has come to overflowing its stack. */
+	#if ( configUSE_COMPACT_TCB == 1 )
+		uint16_t usTaskNameHash;	/* Hash of the task name, pcTaskName is NULL when configUSE_COMPACT_TCB is set to 1. */
+	#endif
 } TaskStatus_t;
 
 /* Possible return values for eTaskConfirmSleepModeStatus(). */
@@ -539,6 +542,48 @@ void vTaskDelete( TaskHandle_t xTaskToDelete ) PRIVILEGED_FUNCTION;
  */
 void vTaskDelay( const TickType_t xTicksToDelay ) PRIVILEGED_FUNCTION;
 
+/**
+ * task. h
+ * <pre>void vTaskDelayWithSlack( const TickType_t xTicksToDelay, const TickType_t xSlack );</pre>
+ *
+ * INCLUDE_vTaskDelayWithSlack must be defined as 1 for this function to be
+ * available.  See the configuration section for more information.
+ *
+ * Same as vTaskDelay(), except the task accepts to stay blocked for up to
+ * xSlack more ticks.  If another task is already blocked until a time that
+ * falls in this window then the calling task is unblocked together with it,
+ * in a single context switch instead of one for each of them.  Tasks polling
+ * at unrelated rates (sensors, battery, UI) can then share their wakeups.  The
+ * tick interrupt still wakes the CPU on every tick, so with this port no
+ * interrupt is saved, only the switches to and from the idle task.
+ *
+ * @param xTicksToDelay The minimum amount of time, in tick periods, that the
+ * calling task should block.
+ *
+ * @param xSlack The number of tick periods the delay may be extended by.
+ *
+ * \defgroup vTaskDelayWithSlack vTaskDelayWithSlack
+ * \ingroup TaskCtrl
+ */
+void vTaskDelayWithSlack( const TickType_t xTicksToDelay, const TickType_t xSlack ) PRIVILEGED_FUNCTION;
+
+/**
+ * task. h
+ * <pre>uint32_t ulTaskGetContextSwitchesMerged( void );</pre>
+ *
+ * INCLUDE_vTaskDelayWithSlack must be defined as 1 for this function to be
+ * available.
+ *
+ * @return The number of times vTaskDelayWithSlack() extended a delay to share
+ * the wake time of another task, that is the number of context switches
+ * merged with another one.  It is not a number of interrupts avoided, the
+ * tick interrupt runs whether or not a task is unblocked.
+ *
+ * \defgroup ulTaskGetContextSwitchesMerged ulTaskGetContextSwitchesMerged
+ * \ingroup TaskCtrl
+ */
+uint32_t ulTaskGetContextSwitchesMerged( void ) PRIVILEGED_FUNCTION;
+
 /**
  * task. h
  * <pre>void vTaskDelayUntil( TickType_t *pxPreviousWakeTime, const TickType_t xTimeIncrement );</pre>
@@ -1087,6 +1132,26 @@ UBaseType_t uxTaskGetNumberOfTasks( void ) PRIVILEGED_FUNCTION;
  */
 char *pcTaskGetTaskName( TaskHandle_t xTaskToQuery ) PRIVILEGED_FUNCTION; /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
 
+/**
+ * task. h
+ * <PRE>uint16_t usTaskGetNameHash( TaskHandle_t xTaskToQuery );</PRE>
+ *
+ * @return The hash of the name given to the task referenced by the handle
+ * xTaskToQuery when it was created.  Used in place of the task name when
+ * configUSE_COMPACT_TCB is set to 1 in FreeRTOSConfig.h, in which case the
+ * TCB does not store the name itself.  The hash is computed over the first
+ * configMAX_TASK_NAME_LEN - 1 characters of the name with
+ * taskNAME_HASH_STEP(), starting from taskNAME_HASH_SEED, so a trace tool can
+ * compute the same value from the names found in the sources.
+ *
+ * \defgroup usTaskGetNameHash usTaskGetNameHash
+ * \ingroup TaskUtils
+ */
+#define taskNAME_HASH_SEED					( ( uint16_t ) 5381U )
+#define taskNAME_HASH_STEP( usHash, cChar )	( ( uint16_t ) ( ( ( usHash ) * 33U ) ^ ( uint8_t ) ( cChar ) ) )
+
+uint16_t usTaskGetNameHash( TaskHandle_t xTaskToQuery ) PRIVILEGED_FUNCTION;
+
 /**
  * task.h
  * <PRE>UBaseType_t uxTaskGetStackHighWaterMark( TaskHandle_t xTask );</PRE>
@@ -87,8 +87,11 @@ void __attribute__ ( ( interrupt(configTICK_VECTOR) , naked) ) vTickISREntry( vo
 {
 	extern void vPortTickISR( void );
 
-    // Bug in __DATA_MODEL_SMALL_
-	//__bic_SR_register_on_exit( SCG1 + SCG0 + OSCOFF + CPUOFF );
+	// Wake the idle task up, so that hal_power_idle() picks its mode again.
+	// __bic_SR_register_on_exit() gets the offset wrong in a naked function
+	// (bug in __DATA_MODEL_SMALL_), the stacked SR is at 0(SP) on entry.
+	// 0xf0 is SCG1 + SCG0 + OSCOFF + CPUOFF.
+	asm volatile ("bic.w #0xf0, 0(r1)");
 
 	#if configUSE_PREEMPTION == 1
 		extern void vPortPreemptiveTickISR( void );
@@ -26,6 +26,9 @@ typedef unsigned short UBaseType_t;
 #if( configUSE_16_BIT_TICKS == 1 )
 	typedef uint16_t TickType_t;
 	#define portMAX_DELAY ( TickType_t ) 0xffff
+
+	/* The tick count is read in a single access. */
+	#define portTICK_TYPE_IS_ATOMIC 1
 #else
 	typedef uint32_t TickType_t;
 	#define portMAX_DELAY ( TickType_t ) 0xffffffffUL
@@ -0,0 +1,126 @@
+/*
+ * Per-task bump arenas.
+ *
+ * A task that performs many small, short lived allocations while handling a
+ * single event can carve one block from the heap at start up and then serve
+ * those allocations from it.  Allocating is a pointer bump, and everything
+ * allocated while handling the event is released in one go by resetting the
+ * arena to a previously recorded mark.  Compared to calling pvPortMalloc()
+ * and vPortFree() for each object this avoids the heap_2 free list walk and
+ * the fragmentation left behind by blocks of mixed sizes.
+ *
+ * Typical usage from the owning task:
+ *
+ *	static Arena_t xArena;
+ *	size_t xMark;
+ *
+ *	xPortArenaCreate( &xArena, 256 );
+ *	for( ;; )
+ *	{
+ *		xMark = xPortArenaMark( &xArena );
+ *		... pvPortArenaAlloc( &xArena, ... ) while handling one event ...
+ *		vPortArenaReset( &xArena, xMark );
+ *	}
+ *
+ * The arena is not protected against concurrent access - it belongs to a
+ * single task.  Only creation and deletion go through the shared heap.
+ */
+
+#include <stdlib.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+all the API functions to use the MPU wrappers.  That should only be done when
+task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xPortArenaCreate( Arena_t * const pxArena, size_t xSize )
+{
+	configASSERT( pxArena );
+
+	/* Keep the arena size a multiple of the alignment so the last
+	allocation can use the whole block. */
+	xSize &= ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+
+	pxArena->pucBase = ( uint8_t * ) pvPortMalloc( xSize );
+	pxArena->xSize = ( pxArena->pucBase != NULL ) ? xSize : ( size_t ) 0;
+	pxArena->xUsed = ( size_t ) 0;
+	pxArena->xPeakUsed = ( size_t ) 0;
+
+	return ( pxArena->pucBase != NULL ) ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+void vPortArenaDelete( Arena_t * const pxArena )
+{
+	configASSERT( pxArena );
+
+	vPortFree( pxArena->pucBase );
+	pxArena->pucBase = NULL;
+	pxArena->xSize = ( size_t ) 0;
+	pxArena->xUsed = ( size_t ) 0;
+	pxArena->xPeakUsed = ( size_t ) 0;
+}
+/*-----------------------------------------------------------*/
+
+void *pvPortArenaAlloc( Arena_t * const pxArena, size_t xWantedSize )
+{
+void *pvReturn = NULL;
+
+	configASSERT( pxArena );
+
+	/* Ensure that blocks are always aligned to the required number of bytes. */
+	if( ( xWantedSize & portBYTE_ALIGNMENT_MASK ) != 0 )
+	{
+		xWantedSize += ( portBYTE_ALIGNMENT - ( xWantedSize & portBYTE_ALIGNMENT_MASK ) );
+	}
+
+	/* The comparison is written this way round so a huge xWantedSize cannot
+	overflow the addition. */
+	if( ( xWantedSize > 0 ) && ( xWantedSize <= ( pxArena->xSize - pxArena->xUsed ) ) )
+	{
+		pvReturn = ( void * ) ( pxArena->pucBase + pxArena->xUsed );
+		pxArena->xUsed += xWantedSize;
+
+		if( pxArena->xUsed > pxArena->xPeakUsed )
+		{
+			pxArena->xPeakUsed = pxArena->xUsed;
+		}
+	}
+
+	return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortArenaMark( const Arena_t * const pxArena )
+{
+	configASSERT( pxArena );
+
+	return pxArena->xUsed;
+}
+/*-----------------------------------------------------------*/
+
+void vPortArenaReset( Arena_t * const pxArena, size_t xMark )
+{
+	configASSERT( pxArena );
+
+	/* A mark can only move the bump pointer backwards. */
+	configASSERT( xMark <= pxArena->xUsed );
+
+	pxArena->xUsed = xMark;
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortArenaGetPeakUsage( const Arena_t * const pxArena )
+{
+	configASSERT( pxArena );
+
+	return pxArena->xPeakUsed;
+}
+/*-----------------------------------------------------------*/
@@ -99,6 +99,40 @@ privileged Vs unprivileged linkage and placement. */
 	#endif /* INCLUDE_vTaskSuspend */
 #endif /* configUSE_TICKLESS_IDLE */
 
+#if( configUSE_DELAYED_TASK_WHEEL == 1 )
+	/* The wheel does not keep track of the next unblock time. */
+	#if( configUSE_TICKLESS_IDLE != 0 )
+		#error configUSE_DELAYED_TASK_WHEEL cannot be used with configUSE_TICKLESS_IDLE
+	#endif
+
+	/* The bucket of a wake time is selected with a mask. */
+	#if( ( configDELAYED_TASK_WHEEL_SIZE & ( configDELAYED_TASK_WHEEL_SIZE - 1 ) ) != 0 )
+		#error configDELAYED_TASK_WHEEL_SIZE must be a power of two
+	#endif
+#endif /* configUSE_DELAYED_TASK_WHEEL */
+
+#if( configUSE_COMPACT_TCB == 1 )
+	/* The compact TCB relies on the list links being 16 bit wide, which is
+	only true when pointers are 16 bit, that is with the small data model. */
+	#ifndef __DATA_MODEL_SMALL__
+		#error configUSE_COMPACT_TCB requires the small data model
+	#endif
+
+	/* Priorities are stored in a single byte. */
+	#if( configMAX_PRIORITIES > 255 )
+		#error configMAX_PRIORITIES must be lower than 256 if configUSE_COMPACT_TCB is set to 1
+	#endif
+
+	/* The compact TCB does not store the task name, only a hash of it. */
+	#if( ( INCLUDE_pcTaskGetTaskName == 1 ) || ( configUSE_STATS_FORMATTING_FUNCTIONS == 1 ) )
+		#error INCLUDE_pcTaskGetTaskName and configUSE_STATS_FORMATTING_FUNCTIONS must be 0 if configUSE_COMPACT_TCB is set to 1
+	#endif
+
+	typedef uint8_t TaskPriority_t;
+#else
+	typedef UBaseType_t TaskPriority_t;
+#endif /* configUSE_COMPACT_TCB */
+
 /*
  * Defines the size, in words, of the stack allocated to the idle task.
  */
@@ -127,9 +161,13 @@ typedef struct tskTaskControlBlock
 
 	ListItem_t			xGenericListItem;	/*< The list that the state list item of a task is reference from denotes the state of that task (Ready, Blocked, Suspended ). */
 	ListItem_t			xEventListItem;		/*< Used to reference a task from an event list. */
-	UBaseType_t			uxPriority;			/*< The priority of the task.  0 is the lowest priority. */
 	StackType_t			*pxStack;			/*< Points to the start of the stack. */
-	char				pcTaskName[ configMAX_TASK_NAME_LEN ];/*< Descriptive name given to the task when created.  Facilitates debugging only. */ /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+
+	#if ( configUSE_COMPACT_TCB == 1 )
+		uint16_t		usTaskNameHash;		/*< Hash of the name given to the task when created, see usTaskGetNameHash().  Facilitates tracing only. */
+	#else
+		char			pcTaskName[ configMAX_TASK_NAME_LEN ];/*< Descriptive name given to the task when created.  Facilitates debugging only. */ /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+	#endif
 
 	#if ( portSTACK_GROWTH > 0 )
 		StackType_t		*pxEndOfStack;		/*< Points to the end of the stack on architectures where the stack grows up from low memory. */
@@ -144,9 +182,13 @@ typedef struct tskTaskControlBlock
 		UBaseType_t  	uxTaskNumber;		/*< Stores a number specifically for use by third party trace code. */
 	#endif
 
+	/* The priority fields are kept together, so that they share a word when
+	configUSE_COMPACT_TCB stores them in single bytes. */
+	TaskPriority_t		uxPriority;			/*< The priority of the task.  0 is the lowest priority. */
+
 	#if ( configUSE_MUTEXES == 1 )
-		UBaseType_t 	uxBasePriority;		/*< The priority last assigned to the task - used by the priority inheritance mechanism. */
-		UBaseType_t 	uxMutexesHeld;
+		TaskPriority_t 	uxBasePriority;		/*< The priority last assigned to the task - used by the priority inheritance mechanism. */
+		TaskPriority_t 	uxMutexesHeld;
 	#endif
 
 	#if ( configUSE_APPLICATION_TASK_TAG == 1 )
@@ -174,6 +216,40 @@ typedef struct tskTaskControlBlock
 below to enable the use of older kernel aware debuggers. */
 typedef tskTCB TCB_t;
 
+#if ( configUSE_COMPACT_TCB == 1 )
+
+	/* Name handed to the stack overflow hook. */
+	#define taskTCB_NAME( pxTCB ) ( NULL )
+
+	/* Upper bound of the compact TCB size: two list items, the stack
+	pointers, the name hash and the byte sized priority fields, plus the
+	members added by optional features. */
+	#define taskCOMPACT_TCB_OPTIONAL_SIZE												\
+		( ( ( configUSE_TRACE_FACILITY == 1 ) ? 2 * sizeof( UBaseType_t ) : 0 ) +		\
+		  ( ( configUSE_APPLICATION_TASK_TAG == 1 ) ? sizeof( TaskHookFunction_t ) : 0 ) +	\
+		  ( ( configGENERATE_RUN_TIME_STATS == 1 ) ? sizeof( uint32_t ) : 0 ) +			\
+		  ( ( portCRITICAL_NESTING_IN_TCB == 1 ) ? sizeof( UBaseType_t ) : 0 ) +			\
+		  ( ( portSTACK_GROWTH > 0 ) ? sizeof( StackType_t * ) : 0 ) )
+
+	/* The byte sized priority fields, uxPriority and the two mutex ones,
+	padded to the 16 bit alignment of the following members. */
+	#define taskCOMPACT_TCB_PRIORITY_SIZE												\
+		( ( sizeof( TaskPriority_t ) * ( ( configUSE_MUTEXES == 1 ) ? 3 : 1 ) + 1 ) & ~1 )
+
+	#define taskCOMPACT_TCB_MAX_SIZE													\
+		( ( 2 * sizeof( ListItem_t ) ) + ( 2 * sizeof( StackType_t * ) ) +			\
+		  sizeof( uint16_t ) + taskCOMPACT_TCB_PRIORITY_SIZE + taskCOMPACT_TCB_OPTIONAL_SIZE )
+
+	/* Compile time checks of the compact layout. */
+	_Static_assert( sizeof( ListItem_t ) == ( sizeof( TickType_t ) + ( 4 * sizeof( uint16_t ) ) ), "compact list item larger than expected" );
+	_Static_assert( sizeof( TCB_t ) <= taskCOMPACT_TCB_MAX_SIZE, "compact TCB larger than expected" );
+
+#else
+
+	#define taskTCB_NAME( pxTCB ) ( ( pxTCB )->pcTaskName )
+
+#endif /* configUSE_COMPACT_TCB */
+
 /*
  * Some kernel aware debuggers require the data the debugger needs access to to
  * be global, rather than file scope.
@@ -189,10 +265,14 @@ PRIVILEGED_DATA TCB_t * volatile pxCurrentTCB = NULL;
 
 /* Lists for ready and blocked tasks. --------------------*/
 PRIVILEGED_DATA static List_t pxReadyTasksLists[ configMAX_PRIORITIES ];/*< Prioritised ready tasks. */
-PRIVILEGED_DATA static List_t xDelayedTaskList1;						/*< Delayed tasks. */
-PRIVILEGED_DATA static List_t xDelayedTaskList2;						/*< Delayed tasks (two lists are used - one for delays that have overflowed the current tick count. */
-PRIVILEGED_DATA static List_t * volatile pxDelayedTaskList;				/*< Points to the delayed task list currently being used. */
-PRIVILEGED_DATA static List_t * volatile pxOverflowDelayedTaskList;		/*< Points to the delayed task list currently being used to hold tasks that have overflowed the current tick count. */
+#if ( configUSE_DELAYED_TASK_WHEEL == 1 )
+	PRIVILEGED_DATA static List_t xDelayedTaskWheel[ configDELAYED_TASK_WHEEL_SIZE ];	/*< Delayed tasks, unsorted, in the bucket selected by the low bits of their wake time. */
+#else
+	PRIVILEGED_DATA static List_t xDelayedTaskList1;						/*< Delayed tasks. */
+	PRIVILEGED_DATA static List_t xDelayedTaskList2;						/*< Delayed tasks (two lists are used - one for delays that have overflowed the current tick count. */
+	PRIVILEGED_DATA static List_t * volatile pxDelayedTaskList;				/*< Points to the delayed task list currently being used. */
+	PRIVILEGED_DATA static List_t * volatile pxOverflowDelayedTaskList;		/*< Points to the delayed task list currently being used to hold tasks that have overflowed the current tick count. */
+#endif
 PRIVILEGED_DATA static List_t xPendingReadyList;						/*< Tasks that have been readied while the scheduler was suspended.  They will be moved to the ready list when the scheduler is resumed. */
 
 #if ( INCLUDE_vTaskDelete == 1 )
@@ -235,6 +315,12 @@ when the scheduler is unsuspended.  The pending ready list itself can only be
 accessed from a critical section. */
 PRIVILEGED_DATA static volatile UBaseType_t uxSchedulerSuspended	= ( UBaseType_t ) pdFALSE;
 
+#if ( INCLUDE_vTaskDelayWithSlack == 1 )
+
+	PRIVILEGED_DATA static uint32_t ulContextSwitchesMerged = 0UL;	/*< Number of delays that were extended, within their slack, to share the wake time of another task. */
+
+#endif
+
 #if ( configGENERATE_RUN_TIME_STATS == 1 )
 
 	PRIVILEGED_DATA static uint32_t ulTaskSwitchedInTime = 0UL;	/*< Holds the value of a timer/counter the last time a task was switched in. */
@@ -340,21 +426,43 @@ PRIVILEGED_DATA static volatile UBaseType_t uxSchedulerSuspended	= ( UBaseType_t
 
 /*-----------------------------------------------------------*/
 
-/* pxDelayedTaskList and pxOverflowDelayedTaskList are switched when the tick
-count overflows. */
-#define taskSWITCH_DELAYED_LISTS()																	\
-{																									\
-	List_t *pxTemp;																					\
-																									\
-	/* The delayed tasks list should be empty when the lists are switched. */						\
-	configASSERT( ( listLIST_IS_EMPTY( pxDelayedTaskList ) ) );										\
-																									\
-	pxTemp = pxDelayedTaskList;																		\
-	pxDelayedTaskList = pxOverflowDelayedTaskList;													\
-	pxOverflowDelayedTaskList = pxTemp;																\
-	xNumOfOverflows++;																				\
-	prvResetNextTaskUnblockTime();																	\
-}
+#if ( configUSE_DELAYED_TASK_WHEEL == 1 )
+
+	/* Bucket of the delayed task wheel holding the tasks to wake at xTime. */
+	#define taskWHEEL_BUCKET( xTime ) ( &( xDelayedTaskWheel[ ( xTime ) & ( TickType_t ) ( configDELAYED_TASK_WHEEL_SIZE - 1 ) ] ) )
+
+	/* Wake times are compared for equality, a tick count overflow needs no
+	special handling. */
+	#define taskSWITCH_DELAYED_LISTS()																\
+	{																								\
+		xNumOfOverflows++;																			\
+	}
+
+	#define taskIS_DELAYED_LIST( pxList )															\
+		( ( ( pxList ) >= &( xDelayedTaskWheel[ 0 ] ) ) && ( ( pxList ) <= &( xDelayedTaskWheel[ configDELAYED_TASK_WHEEL_SIZE - 1 ] ) ) )
+
+#else
+
+	/* pxDelayedTaskList and pxOverflowDelayedTaskList are switched when the tick
+	count overflows. */
+	#define taskSWITCH_DELAYED_LISTS()																	\
+	{																									\
+		List_t *pxTemp;																					\
+																										\
+		/* The delayed tasks list should be empty when the lists are switched. */						\
+		configASSERT( ( listLIST_IS_EMPTY( pxDelayedTaskList ) ) );										\
+																										\
+		pxTemp = pxDelayedTaskList;																		\
+		pxDelayedTaskList = pxOverflowDelayedTaskList;													\
+		pxOverflowDelayedTaskList = pxTemp;																\
+		xNumOfOverflows++;																				\
+		prvResetNextTaskUnblockTime();																	\
+	}
+
+	#define taskIS_DELAYED_LIST( pxList )																\
+		( ( ( pxList ) == pxDelayedTaskList ) || ( ( pxList ) == pxOverflowDelayedTaskList ) )
+
+#endif /* configUSE_DELAYED_TASK_WHEEL */
 
 /*-----------------------------------------------------------*/
 
@@ -459,6 +567,28 @@ static void prvCheckTasksWaitingTermination( void ) PRIVILEGED_FUNCTION;
  */
 static void prvAddCurrentTaskToDelayedList( const TickType_t xTimeToWake ) PRIVILEGED_FUNCTION;
 
+/*
+ * Block the calling task for xTicksToDelay ticks, extended by up to xSlack
+ * ticks to share the wake time of another task.  Shared by vTaskDelay() and
+ * vTaskDelayWithSlack().
+ */
+#if ( INCLUDE_vTaskDelay == 1 ) || ( INCLUDE_vTaskDelayWithSlack == 1 )
+
+	static void prvTaskDelay( const TickType_t xTicksToDelay, const TickType_t xSlack ) PRIVILEGED_FUNCTION;
+
+#endif
+
+/*
+ * Look for a task already blocked until a time between xTimeToWake and
+ * xTimeToWake + xSlack.  If one is found return its wake time, so both tasks
+ * are unblocked by the same tick, otherwise return xTimeToWake.
+ */
+#if ( INCLUDE_vTaskDelayWithSlack == 1 )
+
+	static TickType_t prvCoalesceWakeTime( const TickType_t xTimeToWake, const TickType_t xSlack ) PRIVILEGED_FUNCTION;
+
+#endif
+
 /*
  * Allocates memory from the heap for a TCB and associated stack.  Checks the
  * allocation was successful.
@@ -869,9 +999,9 @@ TCB_t * pxNewTCB;
 #endif /* INCLUDE_vTaskDelayUntil */
 /*-----------------------------------------------------------*/
 
-#if ( INCLUDE_vTaskDelay == 1 )
+#if ( INCLUDE_vTaskDelay == 1 ) || ( INCLUDE_vTaskDelayWithSlack == 1 )
 
-	void vTaskDelay( const TickType_t xTicksToDelay )
+	static void prvTaskDelay( const TickType_t xTicksToDelay, const TickType_t xSlack )
 	{
 	TickType_t xTimeToWake;
 	BaseType_t xAlreadyYielded = pdFALSE;
@@ -897,6 +1027,25 @@ TCB_t * pxNewTCB;
 				not a problem. */
 				xTimeToWake = xTickCount + xTicksToDelay;
 
+				#if ( INCLUDE_vTaskDelayWithSlack == 1 )
+				{
+					/* Move the wake time within the slack to the wake time of
+					another blocked task if there is one. */
+					if( xSlack > ( TickType_t ) 0U )
+					{
+						xTimeToWake = prvCoalesceWakeTime( xTimeToWake, xSlack );
+					}
+					else
+					{
+						mtCOVERAGE_TEST_MARKER();
+					}
+				}
+				#else
+				{
+					( void ) xSlack;
+				}
+				#endif
+
 				/* We must remove ourselves from the ready list before adding
 				ourselves to the blocked list as the same list item is used for
 				both lists. */
@@ -932,9 +1081,44 @@ TCB_t * pxNewTCB;
 		}
 	}
 
+#endif /* INCLUDE_vTaskDelay || INCLUDE_vTaskDelayWithSlack */
+/*-----------------------------------------------------------*/
+
+#if ( INCLUDE_vTaskDelay == 1 )
+
+	void vTaskDelay( const TickType_t xTicksToDelay )
+	{
+		prvTaskDelay( xTicksToDelay, ( TickType_t ) 0U );
+	}
+
 #endif /* INCLUDE_vTaskDelay */
 /*-----------------------------------------------------------*/
 
+#if ( INCLUDE_vTaskDelayWithSlack == 1 )
+
+	void vTaskDelayWithSlack( const TickType_t xTicksToDelay, const TickType_t xSlack )
+	{
+		prvTaskDelay( xTicksToDelay, xSlack );
+	}
+	/*-----------------------------------------------------------*/
+
+	uint32_t ulTaskGetContextSwitchesMerged( void )
+	{
+	uint32_t ulReturn;
+
+		/* The counter is not atomic on a 16 bit architecture. */
+		taskENTER_CRITICAL();
+		{
+			ulReturn = ulContextSwitchesMerged;
+		}
+		taskEXIT_CRITICAL();
+
+		return ulReturn;
+	}
+
+#endif /* INCLUDE_vTaskDelayWithSlack */
+/*-----------------------------------------------------------*/
+
 #if ( INCLUDE_eTaskGetState == 1 )
 
 	eTaskState eTaskGetState( TaskHandle_t xTask )
@@ -958,7 +1142,7 @@ TCB_t * pxNewTCB;
 			}
 			taskEXIT_CRITICAL();
 
-			if( ( pxStateList == pxDelayedTaskList ) || ( pxStateList == pxOverflowDelayedTaskList ) )
+			if( taskIS_DELAYED_LIST( pxStateList ) )
 			{
 				/* The task being queried is referenced from one of the Blocked
 				lists. */
@@ -1676,12 +1860,23 @@ TickType_t xTaskGetTickCount( void )
 {
 TickType_t xTicks;
 
-	/* Critical section required if running on a 16 bit processor. */
-	taskENTER_CRITICAL();
+	#if ( portTICK_TYPE_IS_ATOMIC == 1 )
 	{
 		xTicks = xTickCount;
 	}
-	taskEXIT_CRITICAL();
+	#else
+	{
+		/* The tick count takes more than one access to read, e.g. a 32 bit
+		tick count on a 16 bit processor.  Rather than taking a critical
+		section, read it until two consecutive reads match.  An increment
+		always changes the low order word, so a read torn by the tick
+		interrupt cannot match the read that follows it. */
+		do
+		{
+			xTicks = xTickCount;
+		} while( xTicks != xTickCount );
+	}
+	#endif
 
 	return xTicks;
 }
@@ -1741,6 +1936,21 @@ UBaseType_t uxTaskGetNumberOfTasks( void )
 #endif /* INCLUDE_pcTaskGetTaskName */
 /*-----------------------------------------------------------*/
 
+#if ( configUSE_COMPACT_TCB == 1 )
+
+	uint16_t usTaskGetNameHash( TaskHandle_t xTaskToQuery )
+	{
+	TCB_t *pxTCB;
+
+		/* If null is passed in here then the name of the calling task is being queried. */
+		pxTCB = prvGetTCBFromHandle( xTaskToQuery );
+		configASSERT( pxTCB );
+		return pxTCB->usTaskNameHash;
+	}
+
+#endif /* configUSE_COMPACT_TCB */
+/*-----------------------------------------------------------*/
+
 #if ( configUSE_TRACE_FACILITY == 1 )
 
 	UBaseType_t uxTaskGetSystemState( TaskStatus_t * const pxTaskStatusArray, const UBaseType_t uxArraySize, uint32_t * const pulTotalRunTime )
@@ -1763,8 +1973,19 @@ UBaseType_t uxTaskGetNumberOfTasks( void )
 
 				/* Fill in an TaskStatus_t structure with information on each
 				task in the Blocked state. */
-				uxTask += prvListTaskWithinSingleList( &( pxTaskStatusArray[ uxTask ] ), ( List_t * ) pxDelayedTaskList, eBlocked );
-				uxTask += prvListTaskWithinSingleList( &( pxTaskStatusArray[ uxTask ] ), ( List_t * ) pxOverflowDelayedTaskList, eBlocked );
+				#if ( configUSE_DELAYED_TASK_WHEEL == 1 )
+				{
+					for( uxQueue = ( UBaseType_t ) 0U; uxQueue < ( UBaseType_t ) configDELAYED_TASK_WHEEL_SIZE; uxQueue++ )
+					{
+						uxTask += prvListTaskWithinSingleList( &( pxTaskStatusArray[ uxTask ] ), &( xDelayedTaskWheel[ uxQueue ] ), eBlocked );
+					}
+				}
+				#else
+				{
+					uxTask += prvListTaskWithinSingleList( &( pxTaskStatusArray[ uxTask ] ), ( List_t * ) pxDelayedTaskList, eBlocked );
+					uxTask += prvListTaskWithinSingleList( &( pxTaskStatusArray[ uxTask ] ), ( List_t * ) pxOverflowDelayedTaskList, eBlocked );
+				}
+				#endif /* configUSE_DELAYED_TASK_WHEEL */
 
 				#if( INCLUDE_vTaskDelete == 1 )
 				{
@@ -1877,6 +2098,54 @@ BaseType_t xSwitchRequired = pdFALSE;
 				mtCOVERAGE_TEST_MARKER();
 			}
 
+			#if ( configUSE_DELAYED_TASK_WHEEL == 1 )
+			{
+			List_t * const pxBucket = taskWHEEL_BUCKET( xConstTickCount );
+			ListItem_t *pxItem = listGET_HEAD_ENTRY( pxBucket );
+
+				/* Only the bucket of this tick can hold tasks to unblock.  The
+				tasks in it that wake on a later turn of the wheel are skipped. */
+				while( pxItem != listGET_END_MARKER( pxBucket ) )
+				{
+					pxTCB = ( TCB_t * ) listGET_LIST_ITEM_OWNER( pxItem );
+					pxItem = listGET_NEXT( pxItem );
+					xItemValue = listGET_LIST_ITEM_VALUE( &( pxTCB->xGenericListItem ) );
+
+					if( xItemValue != xConstTickCount )
+					{
+						mtCOVERAGE_TEST_MARKER();
+						continue;
+					}
+
+					/* It is time to remove the item from the Blocked state. */
+					( void ) uxListRemove( &( pxTCB->xGenericListItem ) );
+
+					if( listLIST_ITEM_CONTAINER( &( pxTCB->xEventListItem ) ) != NULL )
+					{
+						( void ) uxListRemove( &( pxTCB->xEventListItem ) );
+					}
+					else
+					{
+						mtCOVERAGE_TEST_MARKER();
+					}
+
+					prvAddTaskToReadyList( pxTCB );
+
+					#if (  configUSE_PREEMPTION == 1 )
+					{
+						if( pxTCB->uxPriority >= pxCurrentTCB->uxPriority )
+						{
+							xSwitchRequired = pdTRUE;
+						}
+						else
+						{
+							mtCOVERAGE_TEST_MARKER();
+						}
+					}
+					#endif /* configUSE_PREEMPTION */
+				}
+			}
+			#else
 			/* See if this tick has made a timeout expire.  Tasks are stored in
 			the	queue in the order of their wake time - meaning once one task
 			has been found whose block time has not expired there is no need to
@@ -1958,6 +2227,7 @@ BaseType_t xSwitchRequired = pdFALSE;
 					}
 				}
 			}
+			#endif /* configUSE_DELAYED_TASK_WHEEL */
 		}
 
 		/* Tasks of equal priority to the currently running task will share
@@ -2701,6 +2971,21 @@ static portTASK_FUNCTION( prvIdleTask, pvParameters )
 
 static void prvInitialiseTCBVariables( TCB_t * const pxTCB, const char * const pcName, UBaseType_t uxPriority, const MemoryRegion_t * const xRegions, const uint16_t usStackDepth ) /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
 {
+#if ( configUSE_COMPACT_TCB == 1 )
+{
+UBaseType_t x;
+uint16_t usHash = taskNAME_HASH_SEED;
+
+	/* Only keep a hash of the name in the TCB.  The same hash can be computed
+	off target to map trace records back to the task names. */
+	for( x = ( UBaseType_t ) 0; ( x < ( UBaseType_t ) configMAX_TASK_NAME_LEN - 1 ) && ( pcName[ x ] != 0x00 ); x++ )
+	{
+		usHash = taskNAME_HASH_STEP( usHash, pcName[ x ] );
+	}
+
+	pxTCB->usTaskNameHash = usHash;
+}
+#else
 UBaseType_t x;
 
 	/* Store the task name in the TCB. */
@@ -2724,6 +3009,7 @@ UBaseType_t x;
 	/* Ensure the name string is terminated in the case that the string length
 	was greater or equal to configMAX_TASK_NAME_LEN. */
 	pxTCB->pcTaskName[ configMAX_TASK_NAME_LEN - 1 ] = '\0';
+#endif /* configUSE_COMPACT_TCB */
 
 	/* This is used as an array index so must ensure it's not too large.  First
 	remove the privilege bit if one is present. */
@@ -2736,10 +3022,10 @@ UBaseType_t x;
 		mtCOVERAGE_TEST_MARKER();
 	}
 
-	pxTCB->uxPriority = uxPriority;
+	pxTCB->uxPriority = ( TaskPriority_t ) uxPriority;
 	#if ( configUSE_MUTEXES == 1 )
 	{
-		pxTCB->uxBasePriority = uxPriority;
+		pxTCB->uxBasePriority = ( TaskPriority_t ) uxPriority;
 		pxTCB->uxMutexesHeld = 0;
 	}
 	#endif /* configUSE_MUTEXES */
@@ -2817,8 +3103,20 @@ UBaseType_t uxPriority;
 		vListInitialise( &( pxReadyTasksLists[ uxPriority ] ) );
 	}
 
-	vListInitialise( &xDelayedTaskList1 );
-	vListInitialise( &xDelayedTaskList2 );
+	#if ( configUSE_DELAYED_TASK_WHEEL == 1 )
+	{
+		for( uxPriority = ( UBaseType_t ) 0U; uxPriority < ( UBaseType_t ) configDELAYED_TASK_WHEEL_SIZE; uxPriority++ )
+		{
+			vListInitialise( &( xDelayedTaskWheel[ uxPriority ] ) );
+		}
+	}
+	#else
+	{
+		vListInitialise( &xDelayedTaskList1 );
+		vListInitialise( &xDelayedTaskList2 );
+	}
+	#endif /* configUSE_DELAYED_TASK_WHEEL */
+
 	vListInitialise( &xPendingReadyList );
 
 	#if ( INCLUDE_vTaskDelete == 1 )
@@ -2833,10 +3131,14 @@ UBaseType_t uxPriority;
 	}
 	#endif /* INCLUDE_vTaskSuspend */
 
-	/* Start with pxDelayedTaskList using list1 and the pxOverflowDelayedTaskList
-	using list2. */
-	pxDelayedTaskList = &xDelayedTaskList1;
-	pxOverflowDelayedTaskList = &xDelayedTaskList2;
+	#if ( configUSE_DELAYED_TASK_WHEEL == 0 )
+	{
+		/* Start with pxDelayedTaskList using list1 and the pxOverflowDelayedTaskList
+		using list2. */
+		pxDelayedTaskList = &xDelayedTaskList1;
+		pxOverflowDelayedTaskList = &xDelayedTaskList2;
+	}
+	#endif /* configUSE_DELAYED_TASK_WHEEL */
 }
 /*-----------------------------------------------------------*/
 
@@ -2886,6 +3188,13 @@ static void prvAddCurrentTaskToDelayedList( const TickType_t xTimeToWake )
 	/* The list item will be inserted in wake time order. */
 	listSET_LIST_ITEM_VALUE( &( pxCurrentTCB->xGenericListItem ), xTimeToWake );
 
+	#if ( configUSE_DELAYED_TASK_WHEEL == 1 )
+	{
+		/* The buckets are not sorted, xTaskIncrementTick() checks the wake
+		time of every task in the bucket of the current tick. */
+		vListInsertEnd( taskWHEEL_BUCKET( xTimeToWake ), &( pxCurrentTCB->xGenericListItem ) );
+	}
+	#else
 	if( xTimeToWake < xTickCount )
 	{
 		/* Wake time has overflowed.  Place this item in the overflow list. */
@@ -2908,9 +3217,99 @@ static void prvAddCurrentTaskToDelayedList( const TickType_t xTimeToWake )
 			mtCOVERAGE_TEST_MARKER();
 		}
 	}
+	#endif /* configUSE_DELAYED_TASK_WHEEL */
 }
 /*-----------------------------------------------------------*/
 
+#if ( INCLUDE_vTaskDelayWithSlack == 1 )
+
+	static TickType_t prvCoalesceWakeTime( const TickType_t xTimeToWake, const TickType_t xSlack )
+	#if ( configUSE_DELAYED_TASK_WHEEL == 1 )
+	{
+	const List_t *pxBucket;
+	const ListItem_t *pxItem;
+	TickType_t xOffset, xDistance, xBest = xSlack;
+	BaseType_t xFound = pdFALSE;
+
+		/* A wake time xOffset ticks after xTimeToWake can only be in the
+		bucket xOffset buckets further, or in the same bucket on a later turn
+		of the wheel.  The buckets are walked in order until no bucket left
+		can hold a wake time closer than the best one found. */
+		for( xOffset = 0; ( xOffset <= xBest ) && ( xOffset < ( TickType_t ) configDELAYED_TASK_WHEEL_SIZE ); xOffset++ )
+		{
+			pxBucket = taskWHEEL_BUCKET( xTimeToWake + xOffset );
+
+			for( pxItem = listGET_HEAD_ENTRY( pxBucket ); pxItem != listGET_END_MARKER( pxBucket ); pxItem = listGET_NEXT( pxItem ) )
+			{
+				xDistance = listGET_LIST_ITEM_VALUE( pxItem ) - xTimeToWake;
+
+				if( xDistance <= xBest )
+				{
+					xBest = xDistance;
+					xFound = pdTRUE;
+				}
+			}
+		}
+
+		if( xFound == pdFALSE )
+		{
+			return xTimeToWake;
+		}
+
+		if( xBest != 0 )
+		{
+			ulContextSwitchesMerged++;
+		}
+
+		return xTimeToWake + xBest;
+	}
+	#else
+	{
+	const List_t *pxList;
+	const ListItem_t *pxItem;
+	TickType_t xWakeTime, xReturn = xTimeToWake;
+
+		/* Only the list xTimeToWake would be inserted in is searched, a wake
+		time in the other list is either before xTimeToWake or follows a tick
+		count overflow. */
+		if( xTimeToWake < xTickCount )
+		{
+			pxList = pxOverflowDelayedTaskList;
+		}
+		else
+		{
+			pxList = pxDelayedTaskList;
+		}
+
+		/* The list is in wake time order, the first wake time not before
+		xTimeToWake is the only candidate. */
+		for( pxItem = listGET_HEAD_ENTRY( pxList ); pxItem != listGET_END_MARKER( pxList ); pxItem = listGET_NEXT( pxItem ) )
+		{
+			xWakeTime = listGET_LIST_ITEM_VALUE( pxItem );
+
+			if( xWakeTime >= xTimeToWake )
+			{
+				if( ( TickType_t ) ( xWakeTime - xTimeToWake ) <= xSlack )
+				{
+					if( xWakeTime != xTimeToWake )
+					{
+						ulContextSwitchesMerged++;
+					}
+
+					xReturn = xWakeTime;
+				}
+
+				break;
+			}
+		}
+
+		return xReturn;
+	}
+	#endif /* configUSE_DELAYED_TASK_WHEEL */
+
+#endif /* INCLUDE_vTaskDelayWithSlack */
+/*-----------------------------------------------------------*/
+
 static TCB_t *prvAllocateTCBAndStack( const uint16_t usStackDepth, StackType_t * const puxStackBuffer )
 {
 TCB_t *pxNewTCB;
@@ -2968,7 +3367,16 @@ TCB_t *pxNewTCB;
 				listGET_OWNER_OF_NEXT_ENTRY( pxNextTCB, pxList );
 
 				pxTaskStatusArray[ uxTask ].xHandle = ( TaskHandle_t ) pxNextTCB;
-				pxTaskStatusArray[ uxTask ].pcTaskName = ( const char * ) &( pxNextTCB->pcTaskName [ 0 ] );
+				#if ( configUSE_COMPACT_TCB == 1 )
+				{
+					pxTaskStatusArray[ uxTask ].pcTaskName = NULL;
+					pxTaskStatusArray[ uxTask ].usTaskNameHash = pxNextTCB->usTaskNameHash;
+				}
+				#else
+				{
+					pxTaskStatusArray[ uxTask ].pcTaskName = ( const char * ) &( pxNextTCB->pcTaskName [ 0 ] );
+				}
+				#endif
 				pxTaskStatusArray[ uxTask ].xTaskNumber = pxNextTCB->uxTCBNumber;
 				pxTaskStatusArray[ uxTask ].eCurrentState = eState;
 				pxTaskStatusArray[ uxTask ].uxCurrentPriority = pxNextTCB->uxPriority;
@@ -3106,6 +3514,12 @@ TCB_t *pxNewTCB;
 
 static void prvResetNextTaskUnblockTime( void )
 {
+#if ( configUSE_DELAYED_TASK_WHEEL == 1 )
+
+	/* The wheel is scanned on every tick, xNextTaskUnblockTime is not used. */
+
+#else
+
 TCB_t *pxTCB;
 
 	if( listLIST_IS_EMPTY( pxDelayedTaskList ) != pdFALSE )
@@ -3126,6 +3540,8 @@ TCB_t *pxTCB;
 		( pxTCB ) = ( TCB_t * ) listGET_OWNER_OF_HEAD_ENTRY( pxDelayedTaskList );
 		xNextTaskUnblockTime = listGET_LIST_ITEM_VALUE( &( ( pxTCB )->xGenericListItem ) );
 	}
+
+#endif /* configUSE_DELAYED_TASK_WHEEL */
 }
 /*-----------------------------------------------------------*/
 
@@ -96,6 +96,23 @@ configUSE_TIMERS is set to 1 in FreeRTOSConfig.h. */
 /* Misc definitions. */
 #define tmrNO_DELAY		( TickType_t ) 0U
 
+#if ( configUSE_TIMER_WHEEL == 1 )
+
+	/* Geometry of the hierarchical timing wheel.  Each level has
+	tmrWHEEL_SLOTS slots, a slot of level n spanning tmrWHEEL_SLOTS^n ticks,
+	and enough levels are used to cover the whole TickType_t range.  The
+	occupancy of the slots of a level is tracked in a 16 bit mask. */
+	#define tmrWHEEL_SLOT_BITS	( 4 )
+	#define tmrWHEEL_SLOTS		( 1 << tmrWHEEL_SLOT_BITS )
+	#define tmrWHEEL_SLOT_MASK	( ( UBaseType_t ) tmrWHEEL_SLOTS - 1U )
+	#define tmrWHEEL_LEVELS		( ( ( sizeof( TickType_t ) * 8 ) + tmrWHEEL_SLOT_BITS - 1 ) / tmrWHEEL_SLOT_BITS )
+
+	/* Shift and mask giving the index of the slot of a level. */
+	#define tmrWHEEL_SHIFT( uxLevel )					( tmrWHEEL_SLOT_BITS * ( uxLevel ) )
+	#define tmrWHEEL_INDEX( xTime, uxLevel )			( ( UBaseType_t ) ( ( xTime ) >> tmrWHEEL_SHIFT( uxLevel ) ) & tmrWHEEL_SLOT_MASK )
+
+#endif /* configUSE_TIMER_WHEEL */
+
 /* The definition of the timers themselves. */
 typedef struct tmrTimerControl
 {
@@ -153,13 +170,32 @@ typedef struct tmrTimerQueueMessage
 /*lint -e956 A manual analysis and inspection has been used to determine which
 static variables must be declared volatile. */
 
-/* The list in which active timers are stored.  Timers are referenced in expire
-time order, with the nearest expiry time at the front of the list.  Only the
-timer service task is allowed to access these lists. */
-PRIVILEGED_DATA static List_t xActiveTimerList1;
-PRIVILEGED_DATA static List_t xActiveTimerList2;
-PRIVILEGED_DATA static List_t *pxCurrentTimerList;
-PRIVILEGED_DATA static List_t *pxOverflowTimerList;
+#if ( configUSE_TIMER_WHEEL == 1 )
+
+	/* The hierarchical timing wheel in which active timers are stored.  Each
+	slot is the head of an unsorted, NULL terminated, doubly linked list built
+	from the xTimerListItem members, the pvContainer member of a linked item
+	pointing to the slot.  This makes starting and stopping a timer O(1).  Only
+	the timer service task is allowed to access the wheel. */
+	PRIVILEGED_DATA static ListItem_t *pxTimerWheel[ tmrWHEEL_LEVELS ][ tmrWHEEL_SLOTS ];
+	PRIVILEGED_DATA static uint16_t usTimerWheelOccupied[ tmrWHEEL_LEVELS ];
+	PRIVILEGED_DATA static UBaseType_t uxTimerWheelCount = ( UBaseType_t ) 0U;
+
+	/* The next tick the wheel has to process.  All the ticks before it have
+	been processed, it is never ahead of the tick count by more than one. */
+	PRIVILEGED_DATA static TickType_t xTimerWheelTime = ( TickType_t ) 0U;
+
+#else
+
+	/* The list in which active timers are stored.  Timers are referenced in expire
+	time order, with the nearest expiry time at the front of the list.  Only the
+	timer service task is allowed to access these lists. */
+	PRIVILEGED_DATA static List_t xActiveTimerList1;
+	PRIVILEGED_DATA static List_t xActiveTimerList2;
+	PRIVILEGED_DATA static List_t *pxCurrentTimerList;
+	PRIVILEGED_DATA static List_t *pxOverflowTimerList;
+
+#endif /* configUSE_TIMER_WHEEL */
 
 /* A queue that is used to send commands to the timer service task. */
 PRIVILEGED_DATA static QueueHandle_t xTimerQueue = NULL;
@@ -200,16 +236,52 @@ static void	prvProcessReceivedCommands( void ) PRIVILEGED_FUNCTION;
 static BaseType_t prvInsertTimerInActiveList( Timer_t * const pxTimer, const TickType_t xNextExpiryTime, const TickType_t xTimeNow, const TickType_t xCommandTime ) PRIVILEGED_FUNCTION;
 
 /*
- * An active timer has reached its expire time.  Reload the timer if it is an
- * auto reload timer, then call its callback.
- */
-static void prvProcessExpiredTimer( const TickType_t xNextExpireTime, const TickType_t xTimeNow ) PRIVILEGED_FUNCTION;
-
-/*
- * The tick count has overflowed.  Switch the timer lists after ensuring the
- * current timer list does not still reference some timers.
+ * Remove a timer from the active timers, the timer must be active.
  */
-static void prvSwitchTimerLists( void ) PRIVILEGED_FUNCTION;
+static void prvRemoveTimerFromActiveList( Timer_t * const pxTimer ) PRIVILEGED_FUNCTION;
+
+#if ( configUSE_TIMER_WHEEL == 1 )
+
+	/*
+	 * Link a timer in the wheel, in the slot matching the expiry time stored
+	 * in its list item, relative to xTimerWheelTime.
+	 */
+	static void prvWheelLink( ListItem_t * const pxItem ) PRIVILEGED_FUNCTION;
+
+	/*
+	 * Unlink a timer from the slot it is linked in.
+	 */
+	static void prvWheelUnlink( ListItem_t * const pxItem ) PRIVILEGED_FUNCTION;
+
+	/*
+	 * Return the number of ticks from xTimerWheelTime to the next tick at
+	 * which the wheel has work to do, either a timer expiring or a slot of a
+	 * higher level to cascade down.  The wheel must not be empty.
+	 */
+	static TickType_t prvWheelNextEvent( void ) PRIVILEGED_FUNCTION;
+
+	/*
+	 * Process every tick up to xTimeNow at which the wheel has work to do,
+	 * cascading timers down the levels and expiring the timers of the level 0
+	 * slots.  Leaves xTimerWheelTime set to xTimeNow + 1.
+	 */
+	static void prvProcessExpiredTimers( const TickType_t xTimeNow ) PRIVILEGED_FUNCTION;
+
+#else
+
+	/*
+	 * An active timer has reached its expire time.  Reload the timer if it is an
+	 * auto reload timer, then call its callback.
+	 */
+	static void prvProcessExpiredTimer( const TickType_t xNextExpireTime, const TickType_t xTimeNow ) PRIVILEGED_FUNCTION;
+
+	/*
+	 * The tick count has overflowed.  Switch the timer lists after ensuring the
+	 * current timer list does not still reference some timers.
+	 */
+	static void prvSwitchTimerLists( void ) PRIVILEGED_FUNCTION;
+
+#endif /* configUSE_TIMER_WHEEL */
 
 /*
  * Obtain the current tick count, setting *pxTimerListsWereSwitched to pdTRUE
@@ -371,6 +443,187 @@ Timer_t *pxTimer = ( Timer_t * ) xTimer;
 }
 /*-----------------------------------------------------------*/
 
+#if ( configUSE_TIMER_WHEEL == 1 )
+
+static void prvWheelLink( ListItem_t * const pxItem )
+{
+TickType_t xExpiry, xDelta;
+UBaseType_t uxLevel = ( UBaseType_t ) 0U, uxSlot;
+ListItem_t **ppxHead;
+
+	xExpiry = listGET_LIST_ITEM_VALUE( pxItem );
+	xDelta = xExpiry - xTimerWheelTime;
+
+	/* Use the lowest level whose range covers the time left before the
+	expiry, the last level covers the whole TickType_t range. */
+	while( ( uxLevel < ( UBaseType_t ) ( tmrWHEEL_LEVELS - 1 ) ) && ( ( xDelta >> tmrWHEEL_SHIFT( uxLevel + 1U ) ) != ( TickType_t ) 0U ) )
+	{
+		uxLevel++;
+	}
+
+	uxSlot = tmrWHEEL_INDEX( xExpiry, uxLevel );
+	ppxHead = &( pxTimerWheel[ uxLevel ][ uxSlot ] );
+
+	pxItem->pxPrevious = NULL;
+	pxItem->pxNext = *ppxHead;
+	if( *ppxHead != NULL )
+	{
+		( *ppxHead )->pxPrevious = pxItem;
+	}
+	*ppxHead = pxItem;
+	pxItem->pvContainer = ( void * ) ppxHead;
+
+	usTimerWheelOccupied[ uxLevel ] |= ( uint16_t ) ( 1U << uxSlot );
+	uxTimerWheelCount++;
+}
+/*-----------------------------------------------------------*/
+
+static void prvWheelUnlink( ListItem_t * const pxItem )
+{
+ListItem_t **ppxHead = ( ListItem_t ** ) pxItem->pvContainer;
+UBaseType_t uxIndex;
+
+	if( pxItem->pxPrevious != NULL )
+	{
+		pxItem->pxPrevious->pxNext = pxItem->pxNext;
+	}
+	else
+	{
+		*ppxHead = pxItem->pxNext;
+	}
+
+	if( pxItem->pxNext != NULL )
+	{
+		pxItem->pxNext->pxPrevious = pxItem->pxPrevious;
+	}
+
+	pxItem->pvContainer = NULL;
+	uxTimerWheelCount--;
+
+	if( *ppxHead == NULL )
+	{
+		/* The slot is now empty, the level and slot are found back from the
+		position of the slot in the wheel. */
+		uxIndex = ( UBaseType_t ) ( ppxHead - &( pxTimerWheel[ 0 ][ 0 ] ) );
+		usTimerWheelOccupied[ uxIndex / tmrWHEEL_SLOTS ] &= ( uint16_t ) ~( 1U << ( uxIndex % tmrWHEEL_SLOTS ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static TickType_t prvWheelNextEvent( void )
+{
+TickType_t xSpan, xOffset, xDistance, xNextEvent = portMAX_DELAY;
+UBaseType_t uxLevel, uxIndex, uxStep;
+uint16_t usOccupied;
+
+	for( uxLevel = ( UBaseType_t ) 0U; uxLevel < ( UBaseType_t ) tmrWHEEL_LEVELS; uxLevel++ )
+	{
+		usOccupied = usTimerWheelOccupied[ uxLevel ];
+		if( usOccupied == 0U )
+		{
+			continue;
+		}
+
+		xSpan = ( TickType_t ) 1U << tmrWHEEL_SHIFT( uxLevel );
+		xOffset = xTimerWheelTime & ( xSpan - ( TickType_t ) 1U );
+		uxIndex = tmrWHEEL_INDEX( xTimerWheelTime, uxLevel );
+
+		/* A slot is due when the wheel reaches its first tick.  The current
+		slot is therefore only due now if the wheel is exactly at its start,
+		otherwise it is due a whole turn of the level later. */
+		uxStep = ( xOffset == ( TickType_t ) 0U ) ? ( UBaseType_t ) 0U : ( UBaseType_t ) 1U;
+		while( ( usOccupied & ( 1U << ( ( uxIndex + uxStep ) & tmrWHEEL_SLOT_MASK ) ) ) == 0U )
+		{
+			uxStep++;
+		}
+
+		/* A whole turn of the last level wraps to 0, which is also the
+		right distance modulo the TickType_t range. */
+		xDistance = ( TickType_t ) ( ( ( TickType_t ) uxStep * xSpan ) - xOffset );
+		if( xDistance < xNextEvent )
+		{
+			xNextEvent = xDistance;
+		}
+	}
+
+	return xNextEvent;
+}
+/*-----------------------------------------------------------*/
+
+static void prvProcessExpiredTimers( const TickType_t xTimeNow )
+{
+TickType_t xNextEvent;
+UBaseType_t uxLevel, uxSlot;
+ListItem_t *pxItem;
+Timer_t *pxTimer;
+
+	while( uxTimerWheelCount > ( UBaseType_t ) 0U )
+	{
+		/* Jump over the ticks at which there is nothing to do, stop once the
+		next event is after xTimeNow. */
+		xNextEvent = prvWheelNextEvent();
+		if( xNextEvent >= ( TickType_t ) ( xTimeNow + ( TickType_t ) 1U - xTimerWheelTime ) )
+		{
+			break;
+		}
+
+		xTimerWheelTime += xNextEvent;
+
+		/* At the start of a slot of level n, the current slot of level n + 1
+		is cascaded down: its timers now all expire within the span of a
+		level n slot and are spread over the lower levels. */
+		for( uxLevel = ( UBaseType_t ) 1U; uxLevel < ( UBaseType_t ) tmrWHEEL_LEVELS; uxLevel++ )
+		{
+			if( ( xTimerWheelTime & ( ( ( TickType_t ) 1U << tmrWHEEL_SHIFT( uxLevel ) ) - ( TickType_t ) 1U ) ) != ( TickType_t ) 0U )
+			{
+				break;
+			}
+
+			uxSlot = tmrWHEEL_INDEX( xTimerWheelTime, uxLevel );
+			while( ( pxItem = pxTimerWheel[ uxLevel ][ uxSlot ] ) != NULL )
+			{
+				prvWheelUnlink( pxItem );
+				prvWheelLink( pxItem );
+			}
+		}
+
+		/* Every timer in the current level 0 slot expires now. */
+		uxSlot = tmrWHEEL_INDEX( xTimerWheelTime, 0U );
+		while( ( pxItem = pxTimerWheel[ 0 ][ uxSlot ] ) != NULL )
+		{
+			pxTimer = ( Timer_t * ) listGET_LIST_ITEM_OWNER( pxItem );
+			prvWheelUnlink( pxItem );
+			traceTIMER_EXPIRED( pxTimer );
+
+			/* Auto reload timers are reloaded relative to their expiry time,
+			never in the slot being processed as the period is not 0.  If the
+			timer service task is late the timer is processed again later in
+			this loop. */
+			if( pxTimer->uxAutoReload == ( UBaseType_t ) pdTRUE )
+			{
+				listSET_LIST_ITEM_VALUE( pxItem, xTimerWheelTime + pxTimer->xTimerPeriodInTicks );
+				prvWheelLink( pxItem );
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+
+			/* Call the timer callback. */
+			pxTimer->pxCallbackFunction( ( TimerHandle_t ) pxTimer );
+		}
+
+		xTimerWheelTime++;
+	}
+
+	/* Nothing is due up to xTimeNow, the wheel can be moved straight to
+	the next tick. */
+	xTimerWheelTime = xTimeNow + ( TickType_t ) 1U;
+}
+/*-----------------------------------------------------------*/
+
+#else /* configUSE_TIMER_WHEEL */
+
 static void prvProcessExpiredTimer( const TickType_t xNextExpireTime, const TickType_t xTimeNow )
 {
 BaseType_t xResult;
@@ -411,6 +664,8 @@ Timer_t * const pxTimer = ( Timer_t * ) listGET_OWNER_OF_HEAD_ENTRY( pxCurrentTi
 }
 /*-----------------------------------------------------------*/
 
+#endif /* configUSE_TIMER_WHEEL */
+
 static void prvTimerTask( void *pvParameters )
 {
 TickType_t xNextExpireTime;
@@ -435,6 +690,124 @@ BaseType_t xListWasEmpty;
 }
 /*-----------------------------------------------------------*/
 
+#if ( configUSE_TIMER_WHEEL == 1 )
+
+static void prvProcessTimerOrBlockTask( const TickType_t xNextExpireTime, const BaseType_t xListWasEmpty )
+{
+TickType_t xTimeNow;
+
+	vTaskSuspendAll();
+	{
+		/* Obtain the time now to make an assessment as to whether the next
+		wheel event has been reached or not.  Times are compared relative to
+		xTimerWheelTime so the tick count overflowing needs no special
+		handling.  xTimerWheelTime is left at xTimeNow + 1 once the wheel has
+		caught up, so the distance to the tick after xTimeNow is used, as in
+		prvProcessExpiredTimers(). */
+		xTimeNow = xTaskGetTickCount();
+		if( ( xListWasEmpty == pdFALSE ) && ( ( TickType_t ) ( xNextExpireTime - xTimerWheelTime ) < ( TickType_t ) ( xTimeNow + ( TickType_t ) 1U - xTimerWheelTime ) ) )
+		{
+			( void ) xTaskResumeAll();
+			prvProcessExpiredTimers( xTimeNow );
+		}
+		else
+		{
+			/* Block to wait for the next wheel event or a command to be
+			received - whichever comes first.  With no active timer only a
+			command can make the task do something. */
+			if( xListWasEmpty == pdFALSE )
+			{
+				vQueueWaitForMessageRestricted( xTimerQueue, ( xNextExpireTime - xTimeNow ) );
+			}
+			else
+			{
+				vQueueWaitForMessageRestricted( xTimerQueue, portMAX_DELAY );
+			}
+
+			if( xTaskResumeAll() == pdFALSE )
+			{
+				/* Yield to wait for either a command to arrive, or the block time
+				to expire.  If a command arrived between the critical section being
+				exited and this yield then the yield will not cause the task
+				to block. */
+				portYIELD_WITHIN_API();
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static TickType_t prvGetNextExpireTime( BaseType_t * const pxListWasEmpty )
+{
+TickType_t xNextExpireTime;
+
+	/* The next expire time is the next tick at which the wheel has work to
+	do, which may only be a cascade of timers between the levels. */
+	if( uxTimerWheelCount > ( UBaseType_t ) 0U )
+	{
+		*pxListWasEmpty = pdFALSE;
+		xNextExpireTime = xTimerWheelTime + prvWheelNextEvent();
+	}
+	else
+	{
+		*pxListWasEmpty = pdTRUE;
+		xNextExpireTime = ( TickType_t ) 0U;
+	}
+
+	return xNextExpireTime;
+}
+/*-----------------------------------------------------------*/
+
+static TickType_t prvSampleTimeNow( BaseType_t * const pxTimerListsWereSwitched )
+{
+TickType_t xTimeNow;
+
+	/* Bring the wheel up to date so new timers are linked relative to the
+	current time, their delay is then never larger than the wheel range. */
+	xTimeNow = xTaskGetTickCount();
+	prvProcessExpiredTimers( xTimeNow );
+
+	/* There are no lists to switch with the wheel. */
+	*pxTimerListsWereSwitched = pdFALSE;
+
+	return xTimeNow;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvInsertTimerInActiveList( Timer_t * const pxTimer, const TickType_t xNextExpiryTime, const TickType_t xTimeNow, const TickType_t xCommandTime )
+{
+BaseType_t xProcessTimerNow = pdFALSE;
+
+	listSET_LIST_ITEM_VALUE( &( pxTimer->xTimerListItem ), xNextExpiryTime );
+	listSET_LIST_ITEM_OWNER( &( pxTimer->xTimerListItem ), pxTimer );
+
+	/* Has the expiry time elapsed between the command to start/reset a
+	timer was issued, and the time the command was processed? */
+	if( ( TickType_t ) ( xTimeNow - xCommandTime ) >= ( TickType_t ) ( xNextExpiryTime - xCommandTime ) )
+	{
+		xProcessTimerNow = pdTRUE;
+	}
+	else
+	{
+		prvWheelLink( &( pxTimer->xTimerListItem ) );
+	}
+
+	return xProcessTimerNow;
+}
+/*-----------------------------------------------------------*/
+
+static void prvRemoveTimerFromActiveList( Timer_t * const pxTimer )
+{
+	prvWheelUnlink( &( pxTimer->xTimerListItem ) );
+}
+/*-----------------------------------------------------------*/
+
+#else /* configUSE_TIMER_WHEEL */
+
 static void prvProcessTimerOrBlockTask( const TickType_t xNextExpireTime, const BaseType_t xListWasEmpty )
 {
 TickType_t xTimeNow;
@@ -578,6 +951,14 @@ BaseType_t xProcessTimerNow = pdFALSE;
 }
 /*-----------------------------------------------------------*/
 
+static void prvRemoveTimerFromActiveList( Timer_t * const pxTimer )
+{
+	( void ) uxListRemove( &( pxTimer->xTimerListItem ) );
+}
+/*-----------------------------------------------------------*/
+
+#endif /* configUSE_TIMER_WHEEL */
+
 static void	prvProcessReceivedCommands( void )
 {
 DaemonTaskMessage_t xMessage;
@@ -620,7 +1001,7 @@ TickType_t xTimeNow;
 			if( listIS_CONTAINED_WITHIN( NULL, &( pxTimer->xTimerListItem ) ) == pdFALSE )
 			{
 				/* The timer is in a list, remove it. */
-				( void ) uxListRemove( &( pxTimer->xTimerListItem ) );
+				prvRemoveTimerFromActiveList( pxTimer );
 			}
 			else
 			{
@@ -704,6 +1085,8 @@ TickType_t xTimeNow;
 }
 /*-----------------------------------------------------------*/
 
+#if ( configUSE_TIMER_WHEEL == 0 )
+
 static void prvSwitchTimerLists( void )
 {
 TickType_t xNextExpireTime, xReloadTime;
@@ -763,6 +1146,8 @@ BaseType_t xResult;
 }
 /*-----------------------------------------------------------*/
 
+#endif /* configUSE_TIMER_WHEEL */
+
 static void prvCheckForValidListAndQueue( void )
 {
 	/* Check that the list from which active timers are referenced, and the
@@ -772,10 +1157,14 @@ static void prvCheckForValidListAndQueue( void )
 	{
 		if( xTimerQueue == NULL )
 		{
-			vListInitialise( &xActiveTimerList1 );
-			vListInitialise( &xActiveTimerList2 );
-			pxCurrentTimerList = &xActiveTimerList1;
-			pxOverflowTimerList = &xActiveTimerList2;
+			#if ( configUSE_TIMER_WHEEL == 0 )
+			{
+				vListInitialise( &xActiveTimerList1 );
+				vListInitialise( &xActiveTimerList2 );
+				pxCurrentTimerList = &xActiveTimerList1;
+				pxOverflowTimerList = &xActiveTimerList2;
+			}
+			#endif /* configUSE_TIMER_WHEEL */
 			xTimerQueue = xQueueCreate( ( UBaseType_t ) configTIMER_QUEUE_LENGTH, sizeof( DaemonTaskMessage_t ) );
 			configASSERT( xTimerQueue );
 
@@ -88,18 +88,49 @@
 #define configMAX_PRIORITIES			( 5 )
 #define configTOTAL_HEAP_SIZE			( ( size_t ) ( 10 * 1024 ) )
 #define configMAX_TASK_NAME_LEN			( 10 )
-#define configUSE_TRACE_FACILITY		0
-#define configUSE_16_BIT_TICKS			1
 #define configIDLE_SHOULD_YIELD			1
 #define configUSE_MUTEXES				1
 #define configQUEUE_REGISTRY_SIZE		0
-#define configGENERATE_RUN_TIME_STATS	0
 #define configCHECK_FOR_STACK_OVERFLOW	2
 #define configUSE_RECURSIVE_MUTEXES		1
 #define configUSE_MALLOC_FAILED_HOOK	1
 #define configUSE_APPLICATION_TASK_TAG	0
 #define configUSE_COUNTING_SEMAPHORES	1
 
+/* Store priorities in bytes and a hash of the task name instead of the name
+itself, see CONFIG_FREERTOS_COMPACT_TCB. */
+#ifdef CONFIG_FREERTOS_COMPACT_TCB
+	#define configUSE_COMPACT_TCB		1
+#else
+	#define configUSE_COMPACT_TCB		0
+#endif
+
+/* 16-bit ticks wrap every 64 s at 1024 Hz, see CONFIG_FREERTOS_32_BIT_TICKS. */
+#ifdef CONFIG_FREERTOS_32_BIT_TICKS
+	#define configUSE_16_BIT_TICKS		0
+#else
+	#define configUSE_16_BIT_TICKS		1
+#endif
+
+/* Task states are listed by the shell, see CONFIG_SHELL. */
+#ifdef CONFIG_SHELL
+	#define configUSE_TRACE_FACILITY	1
+#else
+	#define configUSE_TRACE_FACILITY	0
+#endif
+
+/* Count the run time of the tasks in hal_timestamp() units (1/32768 s), see
+CONFIG_FREERTOS_RUN_TIME_STATS. The timestamp is started before the
+scheduler. */
+#ifdef CONFIG_FREERTOS_RUN_TIME_STATS
+	unsigned long hal_timestamp( void );
+	#define configGENERATE_RUN_TIME_STATS	1
+	#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+	#define portGET_RUN_TIME_COUNTER_VALUE()	hal_timestamp()
+#else
+	#define configGENERATE_RUN_TIME_STATS	0
+#endif
+
 #define configMINIMAL_STACK_SIZE		( ( unsigned short ) 90 )
 
 /* Co-routine definitions. */
@@ -112,6 +143,15 @@
 #define configTIMER_QUEUE_LENGTH		10
 #define configTIMER_TASK_STACK_DEPTH	( configMINIMAL_STACK_SIZE )
 
+/* Store the active software timers in a hierarchical timing wheel (O(1)
+start, stop and expiry) instead of the sorted active timer lists. */
+#define configUSE_TIMER_WHEEL			0
+
+/* Hash the delayed tasks into configDELAYED_TASK_WHEEL_SIZE buckets by wake
+time (O(1) block) instead of the sorted delayed task lists. */
+#define configUSE_DELAYED_TASK_WHEEL	0
+#define configDELAYED_TASK_WHEEL_SIZE	16
+
 /* Set the following definitions to 1 to include the API function, or zero
 to exclude the API function. */
 #define INCLUDE_vTaskPrioritySet		1
@@ -121,6 +161,8 @@ to exclude the API function. */
 #define INCLUDE_vTaskSuspend			1
 #define INCLUDE_vTaskDelayUntil			1
 #define INCLUDE_vTaskDelay				1
+#define INCLUDE_vTaskDelayWithSlack		1
+#define INCLUDE_xTaskGetSchedulerState	1
 
 /* The MSP430X port uses a callback function to configure its tick interrupt.
 This allows the application to choose the tick interrupt source.
@@ -0,0 +1,282 @@
+#include <msp430.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+#include "clock.h"
+#include "ti/pmm.h"
+#include "ti/ucs.h"
+
+
+// Number of frequencies whose locked DCO setting is kept
+#define CLOCK_CACHE_SIZE    ( 4 )
+
+// Lowest frequency the FLL is set up for by ti_hal_init_fll()
+#define CLOCK_MIN_HZ        ( 2UL * CONFIG_XT1_CLOCK_HZ )
+
+// Current MCLK and SMCLK frequency
+static unsigned long clock_hz = HAL_CLOCK_MAX_HZ;
+
+// Drivers to notify of the frequency changes
+static hal_clock_listener_t *clock_listeners;
+
+// Number of hal_clock_boost() calls not yet undone
+static unsigned char clock_boosts;
+
+// Serializes the frequency changes once the scheduler runs
+static xSemaphoreHandle clock_mutex;
+
+// DCO tap and modulation (UCSCTL0) the FLL locked on at each frequency used.
+// The DCO restarts from there instead of from its lowest tap, so that the
+// FLL only has to trim it and the settling delay can be skipped.
+static struct {
+    unsigned long hz;
+    unsigned int dco;
+} clock_cache[CLOCK_CACHE_SIZE];
+static unsigned char clock_cache_next;
+
+
+/*******************************************************************************
+ * \brief   Lowest core voltage level for a frequency
+ *
+ *          The level is never below CONFIG_CPU_VCORE_MIN.
+ *          @see page 15 of slas612e.pdf
+ *
+ * \param unsigned long     Frequency in Hz
+ * \return unsigned char    PMMCOREV_x
+ ******************************************************************************/
+static unsigned char clock_vcore( unsigned long hz )
+{
+    unsigned char level;
+
+    if (hz <= 8000000UL)
+        level = PMMCOREV_0;
+    else if (hz <= 12000000UL)
+        level = PMMCOREV_1;
+    else if (hz <= 20000000UL)
+        level = PMMCOREV_2;
+    else
+        level = PMMCOREV_3;
+
+    return (level < CONFIG_CPU_VCORE_MIN) ? CONFIG_CPU_VCORE_MIN : level;
+}
+
+/*******************************************************************************
+ * \brief   Call the listeners
+ *
+ * \param unsigned char     HAL_CLOCK_xxx_CHANGE
+ * \param unsigned long     New frequency in Hz
+ * \return void
+ ******************************************************************************/
+static void clock_notify( unsigned char event, unsigned long hz )
+{
+    hal_clock_listener_t *listener;
+
+    for (listener = clock_listeners; listener; listener = listener->next)
+        listener->callback(event, hz);
+}
+
+/*******************************************************************************
+ * \brief   Program the FLL for a frequency
+ *
+ *          A frequency used before restarts from its cached DCO setting.
+ *          Otherwise the DCO starts from its lowest tap, below the new
+ *          frequency, and the FLL is given the worst case time to settle.
+ *
+ * \param unsigned long     Frequency in Hz
+ * \return void
+ ******************************************************************************/
+static void clock_fll( unsigned long hz )
+{
+    unsigned int ratio = hz / CONFIG_XT1_CLOCK_HZ;
+    unsigned char i;
+
+    for (i = 0; i < CLOCK_CACHE_SIZE; i++) {
+        if (clock_cache[i].hz == hz) {
+            ti_hal_init_fll(hz / 1000, ratio);
+            UCSCTL0 = clock_cache[i].dco;
+            return;
+        }
+    }
+
+    ti_hal_init_fll_settle(hz / 1000, ratio);
+
+    clock_cache[clock_cache_next].hz = hz;
+    clock_cache[clock_cache_next].dco = UCSCTL0;
+    clock_cache_next = (clock_cache_next + 1) % CLOCK_CACHE_SIZE;
+}
+
+/*******************************************************************************
+ * \brief   Change MCLK and SMCLK, without locking
+ *
+ *          The core voltage is raised before the frequency, and lowered
+ *          after it.
+ *
+ * \param unsigned long     Frequency in Hz
+ * \return int              0 if the core voltage could not be raised
+ ******************************************************************************/
+static int clock_change( unsigned long hz )
+{
+    unsigned char level = clock_vcore(hz);
+
+    if (hz == clock_hz) return 1;
+
+    if (level > (PMMCTL0 & PMMCOREV_3) && !ti_hal_set_vcore(level))
+        return 0;
+
+    clock_notify(HAL_CLOCK_PRE_CHANGE, hz);
+
+    clock_fll(hz);
+    clock_hz = hz;
+
+    clock_notify(HAL_CLOCK_POST_CHANGE, hz);
+
+    if (level < (PMMCTL0 & PMMCOREV_3))
+        ti_hal_set_vcore(level);
+
+    return 1;
+}
+
+/*******************************************************************************
+ * \brief   Take the lock of the frequency changes, once the scheduler runs
+ *
+ * \param void
+ * \return void
+ ******************************************************************************/
+static void clock_lock( void )
+{
+    if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED)
+        xSemaphoreTake(clock_mutex, portMAX_DELAY);
+}
+
+/*******************************************************************************
+ * \brief   Give the lock of the frequency changes
+ *
+ * \param void
+ * \return void
+ ******************************************************************************/
+static void clock_unlock( void )
+{
+    if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED)
+        xSemaphoreGive(clock_mutex);
+}
+
+/*******************************************************************************
+ * \brief   Initialize the frequency scaling, once the FLL is locked at
+ *          HAL_CLOCK_MAX_HZ
+ *
+ *          With CONFIG_CPU_CLOCK_SCALING, MCLK drops to
+ *          CONFIG_CPU_CLOCK_LOW_HZ until hal_clock_boost() is called.
+ *
+ * \param void
+ * \return void
+ ******************************************************************************/
+void hal_clock_init( void )
+{
+    clock_hz = HAL_CLOCK_MAX_HZ;
+    clock_cache[0].hz = clock_hz;
+    clock_cache[0].dco = UCSCTL0;
+    clock_cache_next = 1;
+
+    if (!clock_mutex) clock_mutex = xSemaphoreCreateMutex();
+
+#ifdef CONFIG_CPU_CLOCK_SCALING
+    clock_change(CONFIG_CPU_CLOCK_LOW_HZ);
+#endif
+}
+
+/*******************************************************************************
+ * \brief   Change the frequency of MCLK and SMCLK
+ *
+ *          The listeners are called before and after the change. Only from
+ *          tasks or before the scheduler starts. The frequency is kept until
+ *          the next call, or the next boost or unboost.
+ *
+ * \param unsigned long     Frequency in Hz, a multiple of CONFIG_XT1_CLOCK_HZ
+ *                          is exact, clamped to HAL_CLOCK_MAX_HZ
+ * \return int              0 if the core voltage could not be raised
+ ******************************************************************************/
+int hal_clock_set( unsigned long hz )
+{
+    int status;
+
+    if (hz > HAL_CLOCK_MAX_HZ) hz = HAL_CLOCK_MAX_HZ;
+    if (hz < CLOCK_MIN_HZ) hz = CLOCK_MIN_HZ;
+
+    clock_lock();
+    status = clock_change(hz);
+    clock_unlock();
+
+    return status;
+}
+
+/*******************************************************************************
+ * \brief   Get the frequency of MCLK and SMCLK
+ *
+ * \param void
+ * \return unsigned long    Frequency in Hz
+ ******************************************************************************/
+unsigned long hal_clock_get( void )
+{
+    return clock_hz;
+}
+
+/*******************************************************************************
+ * \brief   Run at HAL_CLOCK_MAX_HZ until the matching hal_clock_unboost()
+ *
+ *          Calls nest. Only from tasks or before the scheduler starts.
+ *
+ * \param void
+ * \return void
+ ******************************************************************************/
+void hal_clock_boost( void )
+{
+    clock_lock();
+    if (clock_boosts++ == 0) clock_change(HAL_CLOCK_MAX_HZ);
+    clock_unlock();
+}
+
+/*******************************************************************************
+ * \brief   Undo a hal_clock_boost()
+ *
+ *          With CONFIG_CPU_CLOCK_SCALING, the last one drops MCLK to
+ *          CONFIG_CPU_CLOCK_LOW_HZ.
+ *
+ * \param void
+ * \return void
+ ******************************************************************************/
+void hal_clock_unboost( void )
+{
+    clock_lock();
+#ifdef CONFIG_CPU_CLOCK_SCALING
+    if (--clock_boosts == 0) clock_change(CONFIG_CPU_CLOCK_LOW_HZ);
+#else
+    clock_boosts--;
+#endif
+    clock_unlock();
+}
+
+/*******************************************************************************
+ * \brief   Register a driver to notify of the frequency changes
+ *
+ *          Registering a listener again has no effect.
+ *
+ * \param hal_clock_listener_t *    Listener, must stay valid
+ * \return void
+ ******************************************************************************/
+void hal_clock_register( hal_clock_listener_t *listener )
+{
+    hal_clock_listener_t *l;
+
+    clock_lock();
+
+    for (l = clock_listeners; l && l != listener; l = l->next);
+
+    if (!l) {
+        listener->next = clock_listeners;
+        clock_listeners = listener;
+    }
+
+    clock_unlock();
+}
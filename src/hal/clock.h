@@ -0,0 +1,44 @@
+#ifndef HAL_CLOCK_H
+#define HAL_CLOCK_H
+
+#include "config.h"
+
+
+/*******************************************************************************
+ * Macros
+ ******************************************************************************/
+
+// Highest MCLK frequency, set by hal_setup_clock_pmm()
+#if CONFIG_CPU_CLOCK_HZ > CONFIG_CPU_CLOCK_LIMIT_KHZ * 1000UL
+    #define HAL_CLOCK_MAX_HZ    ( CONFIG_CPU_CLOCK_LIMIT_KHZ * 1000UL )
+#else
+    #define HAL_CLOCK_MAX_HZ    ( CONFIG_CPU_CLOCK_HZ )
+#endif
+
+// Events passed to the clock listeners
+#define HAL_CLOCK_PRE_CHANGE    ( 0 )   // MCLK and SMCLK are about to change
+#define HAL_CLOCK_POST_CHANGE   ( 1 )   // MCLK and SMCLK changed
+
+/*******************************************************************************
+ * Types
+ ******************************************************************************/
+
+// Driver depending on SMCLK, allocated by the caller and linked by
+// hal_clock_register()
+typedef struct hal_clock_listener {
+    void (*callback) (unsigned char event, unsigned long hz);  // Called with the new frequency
+    struct hal_clock_listener *next;                            // Next registered listener
+} hal_clock_listener_t;
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+
+void hal_clock_init( void );
+int hal_clock_set( unsigned long hz );
+unsigned long hal_clock_get( void );
+void hal_clock_boost( void );
+void hal_clock_unboost( void );
+void hal_clock_register( hal_clock_listener_t *listener );
+
+#endif /* HAL_CLOCK_H */
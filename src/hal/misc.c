@@ -2,6 +2,7 @@
 
 #include "msp430.h"
 #include "misc.h"
+#include "clock.h"
 #include "ti/pmm.h"
 #include "ti/ucs.h"
 
@@ -80,4 +81,7 @@ void hal_setup_clock_pmm(void) {
 
     // Clear those flags
     CLEAR_PMM_IFGS();
+
+    // Frequency changes start from the FLL locked above
+    hal_clock_init();
 }
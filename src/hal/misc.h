@@ -2,6 +2,15 @@
 #define HAL_MISC_H
 
 
+/*******************************************************************************
+ * Macros
+ ******************************************************************************/
+
+// Disable the interrupts and restore their previous state. Unlike
+// portEXIT_CRITICAL(), HAL_UNLOCK() does not enable them in an ISR.
+#define HAL_LOCK(_sr)       do { _sr = __get_SR_register() & GIE; __disable_interrupt(); __nop(); } while (0)
+#define HAL_UNLOCK(_sr)     __bis_SR_register(_sr)
+
 /*******************************************************************************
  * Prototypes
  ******************************************************************************/
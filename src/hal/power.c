@@ -0,0 +1,124 @@
+#include <msp430.h>
+
+#include "misc.h"
+#include "power.h"
+
+
+// Number of drivers requiring each clock
+static unsigned char power_holds[HAL_POWER_CLOCKS];
+
+// Number of times each mode was entered and left by hal_power_idle()
+static unsigned long power_entries[HAL_POWER_MODES];
+static unsigned long power_exits[HAL_POWER_MODES];
+
+// SR bits of each mode. SCG0 stops the FLL, SCG1 the DCO when SMCLK does
+// not use it, OSCOFF stops XT1.
+static const unsigned int power_bits[HAL_POWER_MODES] = {
+    [HAL_POWER_ACTIVE] = 0,
+    [HAL_POWER_LPM0] = LPM0_bits,
+    [HAL_POWER_LPM1] = LPM1_bits,
+    [HAL_POWER_LPM3] = LPM3_bits,
+    [HAL_POWER_LPM4] = LPM4_bits,
+};
+
+
+/*******************************************************************************
+ * \brief   Require a clock to keep running while the CPU idles
+ *
+ *          Calls nest, from tasks or ISRs. The idle task picks its mode again
+ *          on the next tick at the latest.
+ *
+ * \param unsigned char     HAL_POWER_xxx clock
+ * \return void
+ ******************************************************************************/
+void hal_power_hold( unsigned char clock )
+{
+    unsigned int sr;
+
+    if (clock >= HAL_POWER_CLOCKS) return;
+
+    HAL_LOCK(sr);
+    power_holds[clock]++;
+    HAL_UNLOCK(sr);
+}
+
+/*******************************************************************************
+ * \brief   Undo a hal_power_hold()
+ *
+ * \param unsigned char     HAL_POWER_xxx clock
+ * \return void
+ ******************************************************************************/
+void hal_power_release( unsigned char clock )
+{
+    unsigned int sr;
+
+    if (clock >= HAL_POWER_CLOCKS) return;
+
+    HAL_LOCK(sr);
+    if (power_holds[clock]) power_holds[clock]--;
+    HAL_UNLOCK(sr);
+}
+
+/*******************************************************************************
+ * \brief   Deepest mode keeping the required clocks running
+ *
+ * \param void
+ * \return unsigned char    HAL_POWER_ACTIVE or HAL_POWER_LPMx
+ ******************************************************************************/
+unsigned char hal_power_mode( void )
+{
+    if (power_holds[HAL_POWER_MCLK]) return HAL_POWER_ACTIVE;
+    if (power_holds[HAL_POWER_DCO]) return HAL_POWER_LPM0;
+    if (power_holds[HAL_POWER_SMCLK]) return HAL_POWER_LPM1;
+    if (power_holds[HAL_POWER_ACLK]) return HAL_POWER_LPM3;
+
+    return HAL_POWER_LPM4;
+}
+
+/*******************************************************************************
+ * \brief   Enter the deepest mode keeping the required clocks running
+ *
+ *          Called by the idle task. The interrupts are enabled together with
+ *          the mode, so that no change of the requirements is missed. Returns
+ *          on the next tick, whose ISR clears the mode of the idle task (see
+ *          vTickISREntry()), other interrupts let it sleep on.
+ *
+ * \param void
+ * \return void
+ ******************************************************************************/
+void hal_power_idle( void )
+{
+    unsigned char mode;
+
+    __disable_interrupt();
+    __nop();
+
+    mode = hal_power_mode();
+    power_entries[mode]++;
+
+    __bis_SR_register(power_bits[mode] | GIE);
+
+    power_exits[mode]++;
+}
+
+/*******************************************************************************
+ * \brief   Get the number of times a mode was entered and left
+ *
+ * \param unsigned char     HAL_POWER_ACTIVE or HAL_POWER_LPMx
+ * \param unsigned long *   Number of exits, may be NULL
+ * \return unsigned long    Number of entries
+ ******************************************************************************/
+unsigned long hal_power_count( unsigned char mode, unsigned long *exits )
+{
+    unsigned long entries;
+    unsigned int sr;
+
+    if (mode >= HAL_POWER_MODES) return 0;
+
+    HAL_LOCK(sr);
+    entries = power_entries[mode];
+    if (exits) *exits = power_exits[mode];
+    HAL_UNLOCK(sr);
+
+    return entries;
+}
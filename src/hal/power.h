@@ -0,0 +1,36 @@
+#ifndef HAL_POWER_H
+#define HAL_POWER_H
+
+#include "config.h"
+
+
+/*******************************************************************************
+ * Macros
+ ******************************************************************************/
+
+// Clocks a driver can require to keep running while the CPU idles
+#define HAL_POWER_MCLK      ( 0 )   // CPU clock, no low power mode at all
+#define HAL_POWER_DCO       ( 1 )   // DCO kept locked by the FLL, LPM0
+#define HAL_POWER_SMCLK     ( 2 )   // SMCLK from the free running DCO, LPM1
+#define HAL_POWER_ACLK      ( 3 )   // ACLK from XT1, LPM3
+#define HAL_POWER_CLOCKS    ( 4 )
+
+// Modes entered by hal_power_idle(), the deepest with nothing required
+#define HAL_POWER_ACTIVE    ( 0 )
+#define HAL_POWER_LPM0      ( 1 )
+#define HAL_POWER_LPM1      ( 2 )
+#define HAL_POWER_LPM3      ( 3 )
+#define HAL_POWER_LPM4      ( 4 )
+#define HAL_POWER_MODES     ( 5 )
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+
+void hal_power_hold( unsigned char clock );
+void hal_power_release( unsigned char clock );
+unsigned char hal_power_mode( void );
+void hal_power_idle( void );
+unsigned long hal_power_count( unsigned char mode, unsigned long *exits );
+
+#endif /* HAL_POWER_H */
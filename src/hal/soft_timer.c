@@ -0,0 +1,290 @@
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+
+#include "misc.h"
+#include "soft_timer.h"
+
+
+// Pending timers, sorted by deadline, the head is the earliest one
+static soft_timer_t *soft_timer_head;
+
+// Number of interrupts saved by expiring timers with a slack together
+static unsigned long soft_timer_avoided;
+
+static void soft_timer_isr( void );
+
+
+/*******************************************************************************
+ * \brief   Compare two TA0R values, handling the counter wrap around
+ *
+ * \param uint16_t          First deadline
+ * \param uint16_t          Second deadline
+ * \return int              Non-zero if the first deadline is before the second
+ ******************************************************************************/
+static inline int soft_timer_before( uint16_t a, uint16_t b )
+{
+    return (int16_t) (a - b) < 0;
+}
+
+/*******************************************************************************
+ * \brief   Latest TA0R value a timer may expire at
+ *
+ *          The deadline plus the slack, cut at SOFT_TIMER_MAX_TICKS from now
+ *          so that it can still be compared with the other deadlines.
+ *
+ * \param soft_timer_t *    Pending timer
+ * \param uint16_t          Current TA0R value
+ * \return uint16_t         End of the expiry window of the timer
+ ******************************************************************************/
+static inline uint16_t soft_timer_latest( const soft_timer_t *timer, uint16_t now )
+{
+    int16_t left = (int16_t) (timer->deadline - now);
+
+    if (left > 0 && timer->slack > SOFT_TIMER_MAX_TICKS - left)
+        return now + SOFT_TIMER_MAX_TICKS;
+
+    return timer->deadline + timer->slack;
+}
+
+/*******************************************************************************
+ * \brief   Insert a timer in the pending queue, keeping it sorted
+ *
+ *          Timers with the same deadline expire in insertion order.
+ *          Must be called with interrupts disabled.
+ *
+ * \param soft_timer_t *    Timer to insert
+ * \return void
+ ******************************************************************************/
+static void soft_timer_insert( soft_timer_t *timer )
+{
+    soft_timer_t **link = &soft_timer_head;
+
+    while (*link && !soft_timer_before(timer->deadline, (*link)->deadline))
+        link = &(*link)->next;
+
+    timer->next = *link;
+    timer->pending = 1;
+    *link = timer;
+}
+
+/*******************************************************************************
+ * \brief   Remove a timer from the pending queue
+ *
+ *          Must be called with interrupts disabled.
+ *
+ * \param soft_timer_t *    Timer to remove
+ * \return void
+ ******************************************************************************/
+static void soft_timer_remove( soft_timer_t *timer )
+{
+    soft_timer_t **link = &soft_timer_head;
+
+    while (*link && *link != timer)
+        link = &(*link)->next;
+
+    if (*link)
+        *link = timer->next;
+
+    timer->pending = 0;
+}
+
+/*******************************************************************************
+ * \brief   Program the compare register for the next wakeup
+ *
+ *          A timer may expire anywhere between its deadline and its deadline
+ *          plus its slack. The wakeup is pushed back as long as this holds for
+ *          every pending timer, so that timers with overlapping windows expire
+ *          together. Must be called with interrupts disabled.
+ *
+ * \param uint16_t          Current TA0R value
+ * \return void
+ ******************************************************************************/
+static void soft_timer_rearm( uint16_t now )
+{
+    uint16_t deadline;
+    soft_timer_t *timer;
+
+    if (!soft_timer_head) {
+        hal_timer_a0_unregister(SOFT_TIMER_SLOT);
+        return;
+    }
+
+    // Only the timers due before the wakeup found so far can bring it
+    // forward, the queue being sorted the walk stops at the first other one
+    deadline = soft_timer_latest(soft_timer_head, now);
+    for (timer = soft_timer_head->next;
+         timer && !soft_timer_before(deadline, timer->deadline);
+         timer = timer->next) {
+        if (soft_timer_before(soft_timer_latest(timer, now), deadline))
+            deadline = soft_timer_latest(timer, now);
+    }
+
+    // A deadline reached while the queue was being updated
+    // is handled on the next counter increment
+    if (soft_timer_before(deadline, now + 1))
+        deadline = now + 1;
+
+    hal_timer_a0_register_at_from_isr(SOFT_TIMER_SLOT, deadline, soft_timer_isr);
+}
+
+/*******************************************************************************
+ * \brief   Start, or restart, a software timer
+ *
+ *          From tasks or ISRs, the timer callbacks included.
+ *
+ * \param soft_timer_t *    Timer to start
+ * \param unsigned int      Number of ticks before the first expiry
+ * \param unsigned int      Number of ticks between expiries, 0 for a one-shot
+ * \param callback          Called from the ISR when the timer expires
+ * \return void
+ ******************************************************************************/
+void hal_soft_timer_start( soft_timer_t *timer, unsigned int ticks, unsigned int period, soft_timer_callback_t callback )
+{
+    unsigned int sr;
+
+    if ( !timer || !callback ) return;
+    if ( ticks < 1 ) ticks = 1;
+    if ( ticks > SOFT_TIMER_MAX_TICKS ) ticks = SOFT_TIMER_MAX_TICKS;
+    if ( period > SOFT_TIMER_MAX_TICKS ) period = SOFT_TIMER_MAX_TICKS;
+
+    HAL_LOCK(sr);
+
+    uint16_t now = hal_timer_a0_count();
+
+    if (timer->pending)
+        soft_timer_remove(timer);
+
+    timer->deadline = now + ticks;
+    timer->period = period;
+    timer->callback = callback;
+    soft_timer_insert(timer);
+
+    soft_timer_rearm(now);
+
+    HAL_UNLOCK(sr);
+}
+
+/*******************************************************************************
+ * \brief   Stop a software timer, nothing is done if it is not running
+ *
+ *          From tasks or ISRs, the timer callbacks included.
+ *
+ * \param soft_timer_t *    Timer to stop
+ * \return void
+ ******************************************************************************/
+void hal_soft_timer_stop( soft_timer_t *timer )
+{
+    unsigned int sr;
+
+    if ( !timer ) return;
+
+    HAL_LOCK(sr);
+
+    if (timer->pending) {
+        int was_head = (soft_timer_head == timer);
+
+        soft_timer_remove(timer);
+
+        if (was_head)
+            soft_timer_rearm(hal_timer_a0_count());
+    }
+
+    HAL_UNLOCK(sr);
+}
+
+/*******************************************************************************
+ * \brief   Set the number of ticks a timer expiry may be delayed by
+ *
+ *          The slack lets the timer expire together with another one instead
+ *          of waking the CPU on its own. Takes effect on the next start. An
+ *          expiry is never delayed past SOFT_TIMER_MAX_TICKS from the time
+ *          the wakeup is computed, whatever the slack.
+ *
+ * \param soft_timer_t *    Timer to configure
+ * \param unsigned int      Slack in TimerA0 ticks, 0 (default) for none
+ * \return void
+ ******************************************************************************/
+void hal_soft_timer_set_slack( soft_timer_t *timer, unsigned int slack )
+{
+    unsigned int sr;
+
+    if ( !timer ) return;
+    if ( slack > SOFT_TIMER_MAX_TICKS ) slack = SOFT_TIMER_MAX_TICKS;
+
+    HAL_LOCK(sr);
+    timer->slack = slack;
+    HAL_UNLOCK(sr);
+}
+
+/*******************************************************************************
+ * \brief   Get the number of wakeups avoided by the timers slack
+ *
+ *          Counts, for each interrupt, the timers expired with a deadline
+ *          different from the first one: each of them would have needed
+ *          its own interrupt without a slack.
+ *
+ * \param void
+ * \return unsigned long    Number of wakeups avoided since boot
+ ******************************************************************************/
+unsigned long hal_soft_timer_wakeups_avoided( void )
+{
+    unsigned long avoided;
+    unsigned int sr;
+
+    HAL_LOCK(sr);
+    avoided = soft_timer_avoided;
+    HAL_UNLOCK(sr);
+
+    return avoided;
+}
+
+/*******************************************************************************
+ * \brief   Expire the pending timers whose deadline is reached
+ *
+ *          Called from hal_timer_a0_isr() when the compare register of
+ *          SOFT_TIMER_SLOT matches. At most SOFT_TIMER_MAX_EXPIRIES timers
+ *          are handled per interrupt to bound the time spent in the ISR.
+ *          Periodic timers are reloaded from their previous deadline, not
+ *          from the current time, so they do not drift.
+ *
+ *          Removing an expired timer is O(1), but a periodic one is queued
+ *          again by a walk of the queue. With n pending timers, an interrupt
+ *          therefore takes up to SOFT_TIMER_MAX_EXPIRIES * n steps with the
+ *          interrupts disabled, see bench/soft_timer_bench.c.
+ *
+ * \param void
+ * \return void
+ ******************************************************************************/
+static void soft_timer_isr( void )
+{
+    uint16_t now = hal_timer_a0_count();
+    unsigned char budget = SOFT_TIMER_MAX_EXPIRIES;
+    unsigned char expired = 0;
+    uint16_t last = 0;
+    soft_timer_t *timer;
+
+    while (budget-- && (timer = soft_timer_head) != NULL &&
+           !soft_timer_before(now, timer->deadline)) {
+
+        soft_timer_head = timer->next;
+        timer->pending = 0;
+
+        // Timers sharing a deadline would have shared the wakeup anyway
+        if (expired++ && timer->deadline != last)
+            soft_timer_avoided++;
+        last = timer->deadline;
+
+        if (timer->period) {
+            timer->deadline += timer->period;
+            soft_timer_insert(timer);
+        }
+
+        // The callback may restart or stop any timer, including this one
+        timer->callback(timer);
+    }
+
+    // The callbacks may have run past the next TA0R increment, a wakeup
+    // computed from the time sampled on entry would then be missed
+    soft_timer_rearm(hal_timer_a0_count());
+}
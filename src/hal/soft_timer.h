@@ -0,0 +1,54 @@
+#ifndef HAL_SOFT_TIMER_H
+#define HAL_SOFT_TIMER_H
+
+#include <stdint.h>
+
+#include "config.h"
+
+#include "timer.h"
+
+
+/*******************************************************************************
+ * Macros
+ ******************************************************************************/
+
+// TimerA0 compare register all the software timers are multiplexed on
+#define SOFT_TIMER_SLOT             TIMER_A0_SLOT4
+
+// Maximum number of expiries handled by one interrupt, the remaining ones are
+// handled by the next interrupt, one TimerA0 tick later. Each periodic expiry
+// walks the pending queue, which bounds an interrupt to this many walks.
+#define SOFT_TIMER_MAX_EXPIRIES     ( 8 )
+
+// Longest timeout, deadlines are compared on the 16 bit TA0R value
+#define SOFT_TIMER_MAX_TICKS        ( 0x7fff )
+
+/*******************************************************************************
+ * Types
+ ******************************************************************************/
+
+struct soft_timer;
+
+typedef void (*soft_timer_callback_t) (struct soft_timer *);
+
+// Software timer, allocated and zeroed by the caller, linked in the pending queue
+// while it is running. The fields are private to soft_timer.c.
+typedef struct soft_timer {
+    struct soft_timer *next;            // Next pending timer, by deadline
+    uint16_t deadline;                  // TA0R value to expire at
+    uint16_t period;                    // Reload value, 0 for a one-shot
+    uint16_t slack;                     // Ticks the expiry may be delayed by
+    soft_timer_callback_t callback;     // Called from the ISR on expiry
+    unsigned char pending;              // Linked in the pending queue
+} soft_timer_t;
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+
+void hal_soft_timer_start( soft_timer_t *timer, unsigned int ticks, unsigned int period, soft_timer_callback_t callback );
+void hal_soft_timer_stop( soft_timer_t *timer );
+void hal_soft_timer_set_slack( soft_timer_t *timer, unsigned int slack );
+unsigned long hal_soft_timer_wakeups_avoided( void );
+
+#endif /* HAL_SOFT_TIMER_H */
@@ -230,20 +230,20 @@ static unsigned int ti_hal_vcore_down(unsigned char level)
 /*******************************************************************************
  * \brief  Set Vcore level
  *
- * \param  level    Level to which Vcore needs to be decreased
- * \return status   Success/failure
+ * \param  level    Level to which Vcore needs to be set
+ * \return status   1 on success, 0 on failure
  ******************************************************************************/
 unsigned int ti_hal_set_vcore(unsigned char level)
 {
     unsigned int actlevel;
     unsigned int status;
 
-    status = 0;
+    status = 1;
     level &= PMMCOREV_3;                    // Set the maximum level
     actlevel = (PMMCTL0 & PMMCOREV_3);      // Get actual VCore
 
-    // Step by step increase or decrease
-    while (((level != actlevel) && (status == 0)) || (level < actlevel)) {
+    // Step by step increase or decrease, stop raising on a failure
+    while (((level != actlevel) && status) || (level < actlevel)) {
         if (level > actlevel) {
             status = ti_hal_vcore_up(++actlevel);
         }  else {
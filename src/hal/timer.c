@@ -1,48 +1,109 @@
 #include "FreeRTOS.h"
 
+#include "misc.h"
+#include "power.h"
 #include "timer.h"
 
 
-static void (*timer_a0_callback_1)(void);
-static void (*timer_a0_callback_2)(void);
-static void (*timer_a0_callback_3)(void);
-static void (*timer_a0_callback_4)(void);
+/*******************************************************************************
+ * Types
+ ******************************************************************************/
+
+// Runtime state of a timer instance
+typedef struct
+{
+    // Callbacks indexed by TAxIV/2, [0] is the CCR0 vector
+    void (*callback[HAL_TIMER_VECTORS])(void);
 
-static unsigned char timer_a0_users;
+    // Reload value of the periodic sub-timers (0 for a one-shot),
+    // and number of periods missed because the ISR ran too late
+    unsigned int period[HAL_TIMER_MAX_SLOTS];
+    unsigned int missed[HAL_TIMER_MAX_SLOTS];
+
+    // One bit per armed compare register, HAL_TIMER_OVERFLOW for TAIE
+    unsigned char users;
+} timer_state_t;
+
+// Description of a timer instance, the CCTLn and CCRn registers of an
+// instance are consecutive and indexed from CCTL0 and CCR0
+typedef struct
+{
+    volatile unsigned int *ctl;
+    volatile unsigned int *cctl;
+    volatile unsigned int *r;
+    volatile unsigned int *ccr;
+    volatile unsigned int *ex0;
+    volatile unsigned int *iv;
+    unsigned int clock;             // Clock source and first divider
+    unsigned int divider;           // Second divider (TAxEX0)
+    unsigned char slots;            // Number of compare registers
+    timer_state_t *state;
+} timer_desc_t;
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static timer_state_t timer_a0_state;
+static timer_state_t timer_a1_state;
+static timer_state_t timer_b0_state;
+
+static const timer_desc_t timers[HAL_TIMER_COUNT] = {
+    // TimerA0, ACLK /4 /8, shares its rate with the RTOS tick on CCR0
+    [HAL_TIMER_A0] = {
+        &TA0CTL, &TA0CCTL0, &TA0R, &TA0CCR0, &TA0EX0, &TA0IV,
+        TASSEL_1 | ID_2, 0x7, 5, &timer_a0_state
+    },
+    // TimerA1, ACLK undivided for high rate sampling
+    [HAL_TIMER_A1] = {
+        &TA1CTL, &TA1CCTL0, &TA1R, &TA1CCR0, &TA1EX0, &TA1IV,
+        TASSEL_1 | ID_0, 0x0, 3, &timer_a1_state
+    },
+    // TimerB0, ACLK undivided
+    [HAL_TIMER_B0] = {
+        &TB0CTL, &TB0CCTL0, &TB0R, &TB0CCR0, &TB0EX0, &TB0IV,
+        TASSEL_1 | ID_0, 0x0, 7, &timer_b0_state
+    },
+};
 
 unsigned int FreeRTOSTickCount = CONFIG_FREERTOS_TICK_COUNT;
 
 
 /*******************************************************************************
- * \brief   Setup TimerA0
+ * \brief   Setup a timer instance
  *
- * \param void
+ * \param unsigned char     Timer instance (HAL_TIMER_xx)
  * \return void
  ******************************************************************************/
-void hal_timer_a0_init( void )
+void hal_timer_init( unsigned char timer )
 {
+    const timer_desc_t *desc;
+
+    if ( timer >= HAL_TIMER_COUNT ) return;
+    desc = &timers[timer];
+
     // Ensure the timer is stopped
-    TA0CTL = 0;
+    *desc->ctl = 0;
 
     // Clear everything to start with
-    TA0CTL |= TACLR;
+    *desc->ctl |= TACLR;
 
     // Configure the second input clock divider
-    TA0EX0 = 0x7;
+    *desc->ex0 = desc->divider;
 
-    timer_a0_users = 0;
+    desc->state->users = 0;
 }
 
 /*******************************************************************************
- * \brief   Get the tick count from the TA0R register
+ * \brief   Get the count from the TAxR register
  *
- * \param void
- * \return unsigned int     Value of the TA0R register
+ * \param const timer_desc_t *  Timer instance
+ * \return unsigned int         Value of the TAxR register
  ******************************************************************************/
-static inline unsigned int GetTickCount(void)
+static inline unsigned int GetTickCount( const timer_desc_t *desc )
 {
     unsigned int value1;
-    unsigned int value2 = TA0R;
+    unsigned int value2 = *desc->r;
 
     // When the timer clock is asynchronous to the CPU clock,
     // any read from TAxR should occur while the timer is not
@@ -55,89 +116,379 @@ static inline unsigned int GetTickCount(void)
     do
     {
         value1 = value2;
-        value2 = TA0R;
+        value2 = *desc->r;
     } while (value1 != value2);
 
     return value1;
 }
 
 /*******************************************************************************
- * \brief   Register a sub-timer to TimerA0
+ * \brief   Get the current value of a timer counter
+ *
+ * \param unsigned char     Timer instance (HAL_TIMER_xx)
+ * \return unsigned int     Value of the TAxR register
+ ******************************************************************************/
+unsigned int hal_timer_count( unsigned char timer )
+{
+    if ( timer >= HAL_TIMER_COUNT ) return 0;
+
+    return GetTickCount(&timers[timer]);
+}
+
+/*******************************************************************************
+ * \brief   Mark a user of the timer, start the timer on the first one
+ *
+ *          Must be called with interrupts disabled.
+ *
+ * \param const timer_desc_t *  Timer instance
+ * \param unsigned char         Compare register or HAL_TIMER_OVERFLOW
+ * \return void
+ ******************************************************************************/
+static void timer_use( const timer_desc_t *desc, unsigned char id )
+{
+    if(desc->state->users == 0) {
+        *desc->ctl |= desc->clock |     // Timer source clock and first divider
+                      MC_2;             // Continuous mode
+
+        // All the instances count ACLK, which must run in the idle task
+        hal_power_hold(HAL_POWER_ACLK);
+    }
+
+    desc->state->users |= (1 << id);
+}
+
+/*******************************************************************************
+ * \brief   Remove a user of the timer, stop the timer on the last one
+ *
+ *          Must be called with interrupts disabled.
+ *
+ * \param const timer_desc_t *  Timer instance
+ * \param unsigned char         Compare register or HAL_TIMER_OVERFLOW
+ * \return void
+ ******************************************************************************/
+static void timer_release( const timer_desc_t *desc, unsigned char id )
+{
+    // A slot already released, by its expiry or never used, holds nothing
+    if (!(desc->state->users & (1 << id))) return;
+
+    desc->state->users &= ~(1 << id);
+
+    if (desc->state->users == 0) {
+        *desc->ctl = 0;
+        hal_power_release(HAL_POWER_ACLK);
+    }
+}
+
+/*******************************************************************************
+ * \brief   Program a compare register and start the timer if needed
+ *
+ *          Must be called with interrupts disabled.
+ *
+ * \param const timer_desc_t *  Timer instance
+ * \param unsigned char         Compare register to use
+ * \param unsigned int          Absolute TAxR value to fire at
+ * \param unsigned int          Period of the sub-timer, 0 for a one-shot
+ * \param void(void)            Callback when the timer is over
+ * \return void
+ ******************************************************************************/
+static void timer_arm( const timer_desc_t *desc, unsigned char id, unsigned int time,
+                       unsigned int period, void (*callback) (void) )
+{
+    desc->cctl[id] = 0;
+    desc->ccr[id] = time;
+    desc->cctl[id] = CCIE;
+
+    desc->state->callback[id] = callback;
+    desc->state->period[id] = period;
+
+    timer_use(desc, id);
+}
+
+/*******************************************************************************
+ * \brief   Disable a compare register and stop the timer if it was the last
+ *
+ *          Must be called with interrupts disabled.
+ *
+ * \param const timer_desc_t *  Timer instance
+ * \param unsigned char         Compare register of the sub-timer
+ * \return void
+ ******************************************************************************/
+static void timer_disarm( const timer_desc_t *desc, unsigned char id )
+{
+    desc->cctl[id] = 0;
+
+    timer_release(desc, id);
+}
+
+/*******************************************************************************
+ * \brief   Check the parameters of a sub-timer registration
+ *
+ *          Only the CCR0 slot may be driven without a callback, this is how
+ *          the RTOS tick uses TIMER_A0_SLOT0.
+ *
+ * \param unsigned char     Timer instance (HAL_TIMER_xx)
+ * \param unsigned char     Compare register to use
+ * \param void(void)        Callback when the timer is over
+ * \return int              1 if valid, 0 otherwise
+ ******************************************************************************/
+static inline int timer_valid( unsigned char timer, unsigned char id, void (*callback) (void) )
+{
+    if ( timer >= HAL_TIMER_COUNT ) return 0;
+    if ( id >= timers[timer].slots ) return 0;
+    if ( id != 0 && !callback ) return 0;
+
+    return 1;
+}
+
+/*******************************************************************************
+ * \brief   Register a sub-timer
  *
+ * \param unsigned char     Timer instance (HAL_TIMER_xx)
  * \param unsigned char     Compare register to use
  * \param unsigned int      Number of ticks to countdown
  * \param void(void)        Callback when the timer is over
  * \return void
  ******************************************************************************/
-void hal_timer_a0_register( unsigned char id, unsigned int ticks, void (*callback) (void) )
+void hal_timer_register( unsigned char timer, unsigned char id, unsigned int ticks, void (*callback) (void) )
 {
+    const timer_desc_t *desc;
+    unsigned int sr;
+
     if ( ticks < 1 ) ticks = 1;
-    if ( id != TIMER_A0_SLOT0 && !callback ) return;
-
-    portENTER_CRITICAL();
-
-    unsigned int time = GetTickCount() + ticks;
-
-    switch(id) {
-        case TIMER_A0_SLOT0:
-            TA0CCTL0 = 0; TA0CCR0 = time; TA0CCTL0 = CCIE;
-            break;
-        case TIMER_A0_SLOT1:
-            TA0CCTL1 = 0; TA0CCR1 = time; TA0CCTL1 = CCIE;
-            timer_a0_callback_1 = callback;
-            break;
-        case TIMER_A0_SLOT2:
-            TA0CCTL2 = 0; TA0CCR2 = time; TA0CCTL2 = CCIE;
-            timer_a0_callback_2 = callback;
-            break;
-        case TIMER_A0_SLOT3:
-            TA0CCTL3 = 0; TA0CCR3 = time; TA0CCTL3 = CCIE;
-            timer_a0_callback_3 = callback;
-            break;
-        case TIMER_A0_SLOT4:
-            TA0CCTL4 = 0; TA0CCR4 = time; TA0CCTL4 = CCIE;
-            timer_a0_callback_4 = callback;
-            break;
-  default:
-            break;
-    }
+    if ( !timer_valid(timer, id, callback) ) return;
+    desc = &timers[timer];
+
+    HAL_LOCK(sr);
+
+    timer_arm(desc, id, GetTickCount(desc) + ticks, 0, callback);
 
-    if(timer_a0_users == 0)
-        TA0CTL |= TASSEL_1 |    // Timer source clock
-                  MC_2 |        // Continuous mode
-                  ID_2;         // Input clock first divider
+    HAL_UNLOCK(sr);
+}
+
+/*******************************************************************************
+ * \brief   Register a periodic sub-timer
+ *
+ *          The compare register is advanced by the period from the ISR, the
+ *          expiries therefore do not drift with the interrupt latency.
+ *          Expiries the ISR was too late for are skipped and counted, see
+ *          hal_timer_missed(). Not available for TIMER_A0_SLOT0, the RTOS
+ *          tick is reloaded by the port. Longer periods are cut to
+ *          HAL_TIMER_MAX_PERIOD, the ISR would take their next expiry for a
+ *          missed one.
+ *
+ * \param unsigned char     Timer instance (HAL_TIMER_xx)
+ * \param unsigned char     Compare register to use
+ * \param unsigned int      Number of ticks between expiries
+ * \param void(void)        Callback when a period is over
+ * \return void
+ ******************************************************************************/
+void hal_timer_register_periodic( unsigned char timer, unsigned char id, unsigned int period, void (*callback) (void) )
+{
+    const timer_desc_t *desc;
+    unsigned int sr;
+
+    if ( period < 1 ) period = 1;
+    if ( period > HAL_TIMER_MAX_PERIOD ) period = HAL_TIMER_MAX_PERIOD;
+    if ( !callback || !timer_valid(timer, id, callback) ) return;
+    if ( timer == HAL_TIMER_A0 && id == TIMER_A0_SLOT0 ) return;
+    desc = &timers[timer];
+
+    HAL_LOCK(sr);
+
+    desc->state->missed[id] = 0;
+    timer_arm(desc, id, GetTickCount(desc) + period, period, callback);
+
+    HAL_UNLOCK(sr);
+}
+
+/*******************************************************************************
+ * \brief   Get the number of expiries missed by a periodic sub-timer
+ *
+ * \param unsigned char     Timer instance (HAL_TIMER_xx)
+ * \param unsigned char     Compare register of the sub-timer
+ * \return unsigned int     Number of periods skipped since registration
+ ******************************************************************************/
+unsigned int hal_timer_missed( unsigned char timer, unsigned char id )
+{
+    unsigned int missed;
+    unsigned int sr;
+
+    if ( timer >= HAL_TIMER_COUNT || id >= timers[timer].slots ) return 0;
 
-    timer_a0_users |= (1 << id);
+    HAL_LOCK(sr);
+    missed = timers[timer].state->missed[id];
+    HAL_UNLOCK(sr);
 
-    portEXIT_CRITICAL();
+    return missed;
 }
 
 /*******************************************************************************
- * \brief   Remove a sub-timer of TimerA0
+ * \brief   Register a sub-timer firing at an absolute TAxR value
  *
+ *          The caller is responsible for the deadline being in the future,
+ *          a deadline already passed fires after the counter wraps around.
+ *
+ * \param unsigned char     Timer instance (HAL_TIMER_xx)
+ * \param unsigned char     Compare register to use
+ * \param unsigned int      TAxR value to fire at
+ * \param void(void)        Callback when the timer is over
+ * \return void
+ ******************************************************************************/
+void hal_timer_register_at( unsigned char timer, unsigned char id, unsigned int time, void (*callback) (void) )
+{
+    unsigned int sr;
+
+    if ( !timer_valid(timer, id, callback) ) return;
+
+    HAL_LOCK(sr);
+
+    timer_arm(&timers[timer], id, time, 0, callback);
+
+    HAL_UNLOCK(sr);
+}
+
+/*******************************************************************************
+ * \brief   Same as hal_timer_register_at(), to be called from an ISR
+ *          (interrupts are already disabled, no critical section is used)
+ *
+ * \param unsigned char     Timer instance (HAL_TIMER_xx)
+ * \param unsigned char     Compare register to use
+ * \param unsigned int      TAxR value to fire at
+ * \param void(void)        Callback when the timer is over
+ * \return void
+ ******************************************************************************/
+void hal_timer_register_at_from_isr( unsigned char timer, unsigned char id, unsigned int time, void (*callback) (void) )
+{
+    if ( !timer_valid(timer, id, callback) ) return;
+
+    timer_arm(&timers[timer], id, time, 0, callback);
+}
+
+/*******************************************************************************
+ * \brief   Remove a sub-timer
+ *
+ * \param unsigned char     Timer instance (HAL_TIMER_xx)
  * \param unsigned char     Compare register of the sub-timer to reset
  * \return void
  ******************************************************************************/
-void hal_timer_a0_unregister( unsigned char id )
+void hal_timer_unregister( unsigned char timer, unsigned char id )
+{
+    unsigned int sr;
+
+    if ( timer >= HAL_TIMER_COUNT || id >= timers[timer].slots ) return;
+
+    HAL_LOCK(sr);
+
+    timer_disarm(&timers[timer], id);
+
+    HAL_UNLOCK(sr);
+}
+
+/*******************************************************************************
+ * \brief   Register a callback on the overflow of the counter (TAIFG)
+ *
+ *          A NULL callback disables the overflow interrupt.
+ *
+ * \param unsigned char     Timer instance (HAL_TIMER_xx)
+ * \param void(void)        Callback when the counter wraps around
+ * \return void
+ ******************************************************************************/
+void hal_timer_register_overflow( unsigned char timer, void (*callback) (void) )
 {
-    portENTER_CRITICAL();
+    const timer_desc_t *desc;
+    unsigned int sr;
+
+    if ( timer >= HAL_TIMER_COUNT ) return;
+    desc = &timers[timer];
+
+    HAL_LOCK(sr);
+
+    desc->state->callback[HAL_TIMER_OVERFLOW] = callback;
 
-    switch (id) {
-        case TIMER_A0_SLOT0: TA0CCTL0 = 0; break;
-        case TIMER_A0_SLOT1: TA0CCTL1 = 0; break;
-        case TIMER_A0_SLOT2: TA0CCTL2 = 0; break;
-        case TIMER_A0_SLOT3: TA0CCTL3 = 0; break;
-        case TIMER_A0_SLOT4: TA0CCTL4 = 0; break;
-        default:
-            break;
+    if (callback) {
+        *desc->ctl = (*desc->ctl & ~TAIFG) | TAIE;
+        timer_use(desc, HAL_TIMER_OVERFLOW);
+    } else {
+        *desc->ctl &= ~(TAIE | TAIFG);
+        timer_release(desc, HAL_TIMER_OVERFLOW);
     }
 
-    timer_a0_users &= ~(1 << id);
+    HAL_UNLOCK(sr);
+}
+
+/*******************************************************************************
+ * \brief   Check if the counter wrapped and the overflow is not handled yet
+ *
+ * \param unsigned char     Timer instance (HAL_TIMER_xx)
+ * \return int              Non-zero if TAIFG is set
+ ******************************************************************************/
+int hal_timer_overflow_pending( unsigned char timer )
+{
+    if ( timer >= HAL_TIMER_COUNT ) return 0;
+
+    return *timers[timer].ctl & TAIFG;
+}
 
-    if (timer_a0_users == 0)
-        TA0CTL = 0;
+/*******************************************************************************
+ * \brief   Advance the compare register of a periodic sub-timer by its period
+ *
+ *          Called from the ISR. If the next expiry is already in the past the
+ *          missed periods are skipped and counted.
+ *
+ * \param const timer_desc_t *  Timer instance
+ * \param unsigned char         Compare register of the sub-timer
+ * \return void
+ ******************************************************************************/
+static inline void timer_reload( const timer_desc_t *desc, unsigned char id )
+{
+    unsigned int period = desc->state->period[id];
+    unsigned int next = desc->ccr[id] + period;
+    unsigned int now = GetTickCount(desc);
+
+    while ((int) (next - now) <= 0) {
+        next += period;
+        desc->state->missed[id]++;
+    }
 
-    portEXIT_CRITICAL();
+    desc->ccr[id] = next;
+}
+
+/*******************************************************************************
+ * \brief   Handle the expiry of a compare register or the counter overflow
+ *
+ * \param const timer_desc_t *  Timer instance
+ * \param unsigned char         Compare register or HAL_TIMER_OVERFLOW
+ * \return void
+ ******************************************************************************/
+static inline void timer_expire( const timer_desc_t *desc, unsigned char id )
+{
+    void (*callback)(void) = desc->state->callback[id];
+
+    if (id != HAL_TIMER_OVERFLOW) {
+        if (desc->state->period[id]) timer_reload(desc, id);
+        else timer_disarm(desc, id);
+    }
+
+    if (callback) callback();
+}
+
+/*******************************************************************************
+ * \brief   Shared body of the TAxIV interrupts
+ *
+ *          The vector register reads 2 * n for CCRn and 0x0E for the overflow,
+ *          TAxIV/2 is therefore the index in the callback array. Reading it
+ *          clears the highest pending flag.
+ *
+ *          @see page 471 of slau208n.pdf
+ *
+ * \param const timer_desc_t *  Timer instance
+ * \return void
+ ******************************************************************************/
+static inline void timer_isr( const timer_desc_t *desc )
+{
+    unsigned int iv = *desc->iv;
+
+    if (iv) timer_expire(desc, iv >> 1);
 }
 
 /*******************************************************************************
@@ -146,7 +497,7 @@ void hal_timer_a0_unregister( unsigned char id )
  *          The first instantiation of TimerA for the MSP430F5438 has 5
  *          capture compare registers. The first one, TA0CCR0 has a dedicated
  *          interrupt vector and the highest priority. This one is used for the
- *          RTOS tick.
+ *          RTOS tick, its interrupt is handled by the port.
  *
  *          @see page 6 of msp430f5438.pdf
  *          @see page 471 of slau208n.pdf
@@ -156,24 +507,49 @@ void hal_timer_a0_unregister( unsigned char id )
  ******************************************************************************/
 void __attribute__ ( ( interrupt(TIMER0_A1_VECTOR) ) ) hal_timer_a0_isr( void )
 {
-    switch (__even_in_range(TA0IV,8)) {
-        case 2:
-            hal_timer_a0_unregister(TIMER_A0_SLOT1);
-            timer_a0_callback_1();
-            break;
-        case 4:
-            hal_timer_a0_unregister(TIMER_A0_SLOT2);
-            timer_a0_callback_2();
-            break;
-        case 6:
-            hal_timer_a0_unregister(TIMER_A0_SLOT3);
-            timer_a0_callback_3();
-            break;
-        case 8:
-            hal_timer_a0_unregister(TIMER_A0_SLOT4);
-            timer_a0_callback_4();
-            break;
-        default:
-            break;
-    }
+    timer_isr(&timers[HAL_TIMER_A0]);
+}
+
+/*******************************************************************************
+ * \brief   ISR to handle the TA1CCR0 CCIFG event
+ *
+ * \param void
+ * \return void
+ ******************************************************************************/
+void __attribute__ ( ( interrupt(TIMER1_A0_VECTOR) ) ) hal_timer_a1_ccr0_isr( void )
+{
+    timer_expire(&timers[HAL_TIMER_A1], 0);
+}
+
+/*******************************************************************************
+ * \brief   ISR to handle TA1CCR1-2 CCIFG events and a timer overflow
+ *
+ * \param void
+ * \return void
+ ******************************************************************************/
+void __attribute__ ( ( interrupt(TIMER1_A1_VECTOR) ) ) hal_timer_a1_isr( void )
+{
+    timer_isr(&timers[HAL_TIMER_A1]);
+}
+
+/*******************************************************************************
+ * \brief   ISR to handle the TB0CCR0 CCIFG event
+ *
+ * \param void
+ * \return void
+ ******************************************************************************/
+void __attribute__ ( ( interrupt(TIMER0_B0_VECTOR) ) ) hal_timer_b0_ccr0_isr( void )
+{
+    timer_expire(&timers[HAL_TIMER_B0], 0);
+}
+
+/*******************************************************************************
+ * \brief   ISR to handle TB0CCR1-6 CCIFG events and a timer overflow
+ *
+ * \param void
+ * \return void
+ ******************************************************************************/
+void __attribute__ ( ( interrupt(TIMER0_B1_VECTOR) ) ) hal_timer_b0_isr( void )
+{
+    timer_isr(&timers[HAL_TIMER_B0]);
 }
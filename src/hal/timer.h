@@ -8,21 +8,58 @@
  * Macros
  ******************************************************************************/
 
+// Timer instances
+#define HAL_TIMER_A0        ( 0 )
+#define HAL_TIMER_A1        ( 1 )
+#define HAL_TIMER_B0        ( 2 )
+#define HAL_TIMER_COUNT     ( 3 )
+
+// Largest number of compare registers of an instance (TimerB0)
+#define HAL_TIMER_MAX_SLOTS ( 7 )
+
+// Pseudo slot of the counter overflow, TAxIV_TAIFG / 2
+#define HAL_TIMER_OVERFLOW  ( 7 )
+#define HAL_TIMER_VECTORS   ( HAL_TIMER_OVERFLOW + 1 )
+
+// Longest period of a periodic sub-timer, expiries are compared with the
+// counter on signed 16 bit differences
+#define HAL_TIMER_MAX_PERIOD    ( 0x7fff )
+
 #define TIMER_A0_SLOT0    ( 0 )
 #define TIMER_A0_SLOT1    ( 1 )
 #define TIMER_A0_SLOT2    ( 2 )
 #define TIMER_A0_SLOT3    ( 3 )
 #define TIMER_A0_SLOT4    ( 4 )
 
+// TimerA0 shortcuts
+#define hal_timer_a0_init()                                 hal_timer_init(HAL_TIMER_A0)
+#define hal_timer_a0_count()                                hal_timer_count(HAL_TIMER_A0)
+#define hal_timer_a0_register(id, ticks, cb)                hal_timer_register(HAL_TIMER_A0, id, ticks, cb)
+#define hal_timer_a0_register_periodic(id, period, cb)      hal_timer_register_periodic(HAL_TIMER_A0, id, period, cb)
+#define hal_timer_a0_missed(id)                             hal_timer_missed(HAL_TIMER_A0, id)
+#define hal_timer_a0_register_at(id, time, cb)              hal_timer_register_at(HAL_TIMER_A0, id, time, cb)
+#define hal_timer_a0_register_at_from_isr(id, time, cb)     hal_timer_register_at_from_isr(HAL_TIMER_A0, id, time, cb)
+#define hal_timer_a0_unregister(id)                         hal_timer_unregister(HAL_TIMER_A0, id)
+
 /*******************************************************************************
  * Prototypes
  ******************************************************************************/
 
-void hal_timer_a0_init( void );
-void hal_timer_a0_register( unsigned char id, unsigned int ticks, void (*callback) (void) );
-void hal_timer_a0_unregister( unsigned char id );
+void hal_timer_init( unsigned char timer );
+unsigned int hal_timer_count( unsigned char timer );
+void hal_timer_register( unsigned char timer, unsigned char id, unsigned int ticks, void (*callback) (void) );
+void hal_timer_register_periodic( unsigned char timer, unsigned char id, unsigned int period, void (*callback) (void) );
+unsigned int hal_timer_missed( unsigned char timer, unsigned char id );
+void hal_timer_register_at( unsigned char timer, unsigned char id, unsigned int time, void (*callback) (void) );
+void hal_timer_register_at_from_isr( unsigned char timer, unsigned char id, unsigned int time, void (*callback) (void) );
+void hal_timer_unregister( unsigned char timer, unsigned char id );
+void hal_timer_register_overflow( unsigned char timer, void (*callback) (void) );
+int hal_timer_overflow_pending( unsigned char timer );
 
 void __attribute__ ( ( interrupt(TIMER0_A1_VECTOR) ) ) hal_timer_a0_isr( void );
+void __attribute__ ( ( interrupt(TIMER1_A0_VECTOR) ) ) hal_timer_a1_ccr0_isr( void );
+void __attribute__ ( ( interrupt(TIMER1_A1_VECTOR) ) ) hal_timer_a1_isr( void );
+void __attribute__ ( ( interrupt(TIMER0_B0_VECTOR) ) ) hal_timer_b0_ccr0_isr( void );
+void __attribute__ ( ( interrupt(TIMER0_B1_VECTOR) ) ) hal_timer_b0_isr( void );
 
 #endif /* HAL_TIMER_H */
-
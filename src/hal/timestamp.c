@@ -0,0 +1,99 @@
+#include "FreeRTOS.h"
+
+#include "timestamp.h"
+
+
+// Number of TimerA1 overflows, the upper part of the timestamp
+static volatile unsigned long timestamp_overflows;
+
+
+/*******************************************************************************
+ * \brief   TimerA1 overflow callback, called from the ISR
+ *
+ * \param void
+ * \return void
+ ******************************************************************************/
+static void timestamp_overflow( void )
+{
+    timestamp_overflows++;
+}
+
+/*******************************************************************************
+ * \brief   Start the timestamp counter
+ *
+ *          TimerA1 is left free running, its compare registers can still be
+ *          used with the timer API at HAL_TIMESTAMP_HZ.
+ *
+ * \param void
+ * \return void
+ ******************************************************************************/
+void hal_timestamp_init( void )
+{
+    timestamp_overflows = 0;
+
+    hal_timer_init(HAL_TIMESTAMP_TIMER);
+    hal_timer_register_overflow(HAL_TIMESTAMP_TIMER, timestamp_overflow);
+}
+
+/*******************************************************************************
+ * \brief   Read the overflow count and the counter as a consistent pair
+ *
+ *          No critical section is used. The overflow count is read again
+ *          until it did not change around the counter read, which also
+ *          catches a torn read of the 32 bit count. With interrupts disabled
+ *          the overflow ISR cannot run, a pending TAIFG with a counter in its
+ *          lower half means the counter already wrapped and is accounted for
+ *          here. This holds as long as interrupts are not disabled for more
+ *          than half a period of the counter (1 s).
+ *
+ * \param unsigned int *    Value of the counter
+ * \return unsigned long    Number of overflows of the counter
+ ******************************************************************************/
+static inline unsigned long timestamp_read( unsigned int *low )
+{
+    unsigned long high;
+    int pending;
+
+    do {
+        high = timestamp_overflows;
+        *low = hal_timer_count(HAL_TIMESTAMP_TIMER);
+        pending = hal_timer_overflow_pending(HAL_TIMESTAMP_TIMER);
+    } while (high != timestamp_overflows);
+
+    if (pending && *low < 0x8000)
+        high++;
+
+    return high;
+}
+
+/*******************************************************************************
+ * \brief   Get a monotonic timestamp, wraps every 36 hours
+ *
+ *          Safe to call from tasks and ISRs.
+ *
+ * \param void
+ * \return unsigned long    Timestamp in 1/HAL_TIMESTAMP_HZ seconds
+ ******************************************************************************/
+unsigned long hal_timestamp( void )
+{
+    unsigned int low;
+    unsigned long high = timestamp_read(&low);
+
+    return (high << 16) | low;
+}
+
+/*******************************************************************************
+ * \brief   Get a monotonic timestamp that does not wrap in practice
+ *
+ *          Safe to call from tasks and ISRs.
+ *
+ * \param void
+ * \return unsigned long long   Timestamp in 1/HAL_TIMESTAMP_HZ seconds
+ ******************************************************************************/
+unsigned long long hal_timestamp64( void )
+{
+    unsigned int low;
+    unsigned long long high = timestamp_read(&low);
+
+    return (high << 16) | low;
+}
@@ -0,0 +1,25 @@
+#ifndef HAL_TIMESTAMP_H
+#define HAL_TIMESTAMP_H
+
+#include "config.h"
+
+#include "timer.h"
+
+
+/*******************************************************************************
+ * Macros
+ ******************************************************************************/
+
+// TimerA1 the timestamp counter runs on, from ACLK undivided
+#define HAL_TIMESTAMP_TIMER     HAL_TIMER_A1
+#define HAL_TIMESTAMP_HZ        ( 32768UL )
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+
+void hal_timestamp_init( void );
+unsigned long hal_timestamp( void );
+unsigned long long hal_timestamp64( void );
+
+#endif /* HAL_TIMESTAMP_H */
@@ -1,7 +1,136 @@
 #include <msp430.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+#include "misc.h"
+#include "clock.h"
+#include "power.h"
 #include "uart.h"
 
 
+#define UART_TX_MASK    ( CONFIG_DEBUG_UART_TX_SIZE - 1 )
+#define UART_RX_MASK    ( CONFIG_DEBUG_UART_RX_SIZE - 1 )
+
+// The receiver listens all the time, BRCLK must run in the idle task
+#ifdef UART_BRCLK_SMCLK
+    #define UART_POWER_CLOCK    HAL_POWER_SMCLK
+#else
+    #define UART_POWER_CLOCK    HAL_POWER_ACLK
+#endif
+
+// Transmit ring, drained from the tail by the TX interrupt. One byte is kept
+// free to tell full from empty. The writers reserve space at uart_tx_reserved
+// and fill it, the interrupt sends up to uart_tx_head which catches up when
+// the last writer in progress commits. The indexes change under HAL_LOCK().
+static char uart_tx_ring[CONFIG_DEBUG_UART_TX_SIZE];
+static volatile unsigned int uart_tx_head;
+static volatile unsigned int uart_tx_tail;
+static volatile unsigned int uart_tx_reserved;
+static volatile unsigned char uart_tx_writers;
+
+// Number of bytes lost because the ring was full
+static unsigned long uart_tx_dropped;
+
+#ifdef CONFIG_DEBUG_UART_DMA
+// Length of the block of the ring the DMA is sending, from the tail
+static volatile unsigned int uart_tx_dma_len;
+
+// Given each time a DMA block is sent
+static xSemaphoreHandle uart_tx_done;
+#endif
+
+// Receive ring, filled at the head by the RX interrupt and emptied from the
+// tail by a single reader task. Each index is only written by one side, no
+// lock is needed. One byte is kept free to tell full from empty.
+static char uart_rx_ring[CONFIG_DEBUG_UART_RX_SIZE];
+static volatile unsigned int uart_rx_head;
+static volatile unsigned int uart_rx_tail;
+
+// Given by the RX interrupt at the end of a line, or when the ring is full
+static xSemaphoreHandle uart_rx_ready;
+
+static void uart_tx_kick( void );
+
+#ifdef UART_BRCLK_SMCLK
+static void uart_clock_changed( unsigned char event, unsigned long hz );
+
+// Baud rate settings follow the SMCLK changes
+static hal_clock_listener_t uart_clock_listener = { uart_clock_changed, NULL };
+#endif
+
+
+#ifdef UART_BRCLK_SMCLK
+
+/*******************************************************************************
+ * \brief   Set the baud rate generator for a clock frequency
+ *
+ *          Same computation as the UART_BR, UART_BRS, UART_BRF and UART_OS16
+ *          macros, at runtime. The USCI must be in reset.
+ *
+ * \param unsigned long     Frequency of BRCLK in Hz
+ * \return void
+ ******************************************************************************/
+static void uart_set_baud( unsigned long hz )
+{
+    unsigned long n_x16 = (2 * 16 * hz + CONFIG_DEBUG_UART_BAUD) / (2 * CONFIG_DEBUG_UART_BAUD);
+    unsigned int n;
+
+    if (n_x16 >= 16 * 16) {
+        // Oversampling mode, UCBRx = INT(N / 16), UCBRFx = N % 16
+        n = (2 * hz + CONFIG_DEBUG_UART_BAUD) / (2 * CONFIG_DEBUG_UART_BAUD);
+        UCA1BR0 = (n / 16) & 0xff;
+        UCA1BR1 = (n / 16) >> 8;
+        UCA1MCTL = ((n % 16) << 4) + UCOS16;
+    } else {
+        // Low frequency mode, UCBRx = INT(N), UCBRSx = N * 8 % 8
+        n = (2 * 8 * hz + CONFIG_DEBUG_UART_BAUD) / (2 * CONFIG_DEBUG_UART_BAUD);
+        UCA1BR0 = (n / 8) & 0xff;
+        UCA1BR1 = (n / 8) >> 8;
+        UCA1MCTL = (n % 8) << 1;
+    }
+}
+
+/*******************************************************************************
+ * \brief   Stop the UART while SMCLK changes, and restart it at the same baud
+ *          rate
+ *
+ *          The transmit ring is drained first, the bytes queued during the
+ *          change are sent after it.
+ *
+ * \param unsigned char     HAL_CLOCK_xxx_CHANGE
+ * \param unsigned long     New SMCLK frequency in Hz
+ * \return void
+ ******************************************************************************/
+static void uart_clock_changed( unsigned char event, unsigned long hz )
+{
+    unsigned int sr;
+
+    if (event == HAL_CLOCK_PRE_CHANGE) {
+        hal_debug_uart_flush();
+
+        HAL_LOCK(sr);
+        UCA1CTL1 |= UCSWRST;
+        HAL_UNLOCK(sr);
+    } else {
+        HAL_LOCK(sr);
+
+        uart_set_baud(hz);
+        UCA1CTL1 &= ~UCSWRST;
+
+        // The reset cleared the interrupt enables and set UCTXIFG
+        UCA1IE = UCRXIE;
+        if (uart_tx_tail != uart_tx_head) uart_tx_kick();
+
+        HAL_UNLOCK(sr);
+    }
+}
+
+#endif /* UART_BRCLK_SMCLK */
+
 /*******************************************************************************
  * \brief   Setup UCA1 UART interface
  *
@@ -18,26 +147,34 @@ void hal_init_debug_uart( void )
     UCA1CTL1 = UCSWRST;
 
     // Select the clock source
-    UCA1CTL1 |= UCSSEL__ACLK;
+    UCA1CTL1 |= UART_BRCLK_SEL;
 
 
-    // Configure the baud rate
+    // Configure the baud rate, computed from CONFIG_DEBUG_UART_BAUD
     // @see page 905, 906 of slau208n.pdf
 
-    // CLK          baud    BRx     BRSx    BRFx
-    // -----------------------------------------
-    // 32768 Hz     9600    3       0       3
+    // CLK          baud    BRx     BRSx    BRFx    UCOS16
+    // -------------------------------------------------
+    // 32768 Hz     9600    3       3       0       0
+    // 20 MHz       460800  2       0       11      1
+    // 20 MHz       921600  1       0       6       1
 
+#ifdef UART_BRCLK_SMCLK
+    // SMCLK may not run at UART_SMCLK_HZ, see hal_clock_set()
+    uart_set_baud(hal_clock_get());
+    hal_clock_register(&uart_clock_listener);
+#else
     // Prescaler value UCBRx (16-bit)
     // @see page 913 of slau208n.pdf
     // BRx = (BR0 + BR1 × 256)
-    UCA1BR0 = 0x03;
-    UCA1BR1 = 0x00;
+    UCA1BR0 = UART_BR & 0xff;
+    UCA1BR1 = UART_BR >> 8;
 
     // First and second modulation stage selection
     // These bits determine the modulation pattern.
     // @see page 913 of slau208n.pdf
-    UCA1MCTL = UCBRS_3 + UCBRF_0;
+    UCA1MCTL = (UART_BRF << 4) + (UART_BRS << 1) + UART_OS16;
+#endif
 
 
     // Reset UCAxSTAT register to clear error flags
@@ -49,25 +186,601 @@ void hal_init_debug_uart( void )
     // Enable USCI_A1 RX interrupt
     UCA1IE = UCRXIE;
 
-    // Clear interrupt flags
-    UCA1IFG = 0;
+    // Clear interrupt flags, except UCTXIFG which must stay set for the
+    // TX interrupt to fire when the transmit ring is kicked
+    UCA1IFG = UCTXIFG;
+
+    uart_tx_head = 0;
+    uart_tx_tail = 0;
+    uart_tx_reserved = 0;
+    uart_tx_writers = 0;
+
+    uart_rx_head = 0;
+    uart_rx_tail = 0;
+
+    if (!uart_rx_ready) {
+        uart_rx_ready = xSemaphoreCreateBinary();
+        hal_power_hold(UART_POWER_CLOCK);
+    }
+
+#ifdef CONFIG_DEBUG_UART_DMA
+    uart_tx_dma_len = 0;
+
+    if (!uart_tx_done) uart_tx_done = xSemaphoreCreateBinary();
+
+    // Byte transfers from the ring to UCA1TXBUF, one per UCTXIFG edge
+    DMA0CTL = 0;
+    DMACTL0 = (DMACTL0 & 0xff00) | UART_DMA_TRIGGER;
+    DMA0DA = (unsigned long) (uintptr_t) &UCA1TXBUF;
+#endif
+}
+
+/*******************************************************************************
+ * \brief   Free space of the transmit ring
+ *
+ *          Must be called with interrupts disabled.
+ *
+ * \param void
+ * \return unsigned int     Number of bytes that can be reserved
+ ******************************************************************************/
+static unsigned int uart_tx_room( void )
+{
+    return (uart_tx_tail - uart_tx_reserved - 1) & UART_TX_MASK;
+}
+
+/*******************************************************************************
+ * \brief   Reserve space in the transmit ring
+ *
+ *          The space must be free, see uart_tx_room(). It is not sent before
+ *          uart_tx_commit() is called. Must be called with interrupts
+ *          disabled.
+ *
+ * \param unsigned int      Number of bytes
+ * \return unsigned int     Offset of the space in the ring
+ ******************************************************************************/
+static unsigned int uart_tx_reserve(unsigned int len)
+{
+    unsigned int pos = uart_tx_reserved;
+
+    uart_tx_reserved = (pos + len) & UART_TX_MASK;
+    uart_tx_writers++;
+
+    return pos;
+}
+
+/*******************************************************************************
+ * \brief   Copy bytes into space reserved in the transmit ring
+ *
+ *          Can be called with interrupts enabled.
+ *
+ * \param unsigned int      Offset of the space in the ring
+ * \param const char *      Bytes to copy
+ * \param unsigned int      Number of bytes
+ * \return void
+ ******************************************************************************/
+static void uart_tx_copy(unsigned int pos, const char *buf, unsigned int len)
+{
+    // Copy in at most two parts, up to the end of the ring and from its start
+    unsigned int chunk = CONFIG_DEBUG_UART_TX_SIZE - pos;
+
+    if (chunk > len) chunk = len;
+
+    memcpy(&uart_tx_ring[pos], buf, chunk);
+    memcpy(&uart_tx_ring[0], buf + chunk, len - chunk);
+}
+
+/*******************************************************************************
+ * \brief   Release a reservation filled with uart_tx_copy()
+ *
+ *          The reserved bytes are sent once all the writers in progress are
+ *          done, in the order they were reserved. Must be called with
+ *          interrupts disabled.
+ *
+ * \param void
+ * \return void
+ ******************************************************************************/
+static void uart_tx_commit( void )
+{
+    if (--uart_tx_writers == 0) {
+        uart_tx_head = uart_tx_reserved;
+        uart_tx_kick();
+    }
+}
+
+/*******************************************************************************
+ * \brief   Copy bytes into the transmit ring and start the transmission
+ *
+ *          Must be called with interrupts disabled.
+ *
+ * \param const char *      Bytes to send
+ * \param unsigned int      Number of bytes
+ * \param int               Drop the oldest bytes instead of the new ones
+ * \return unsigned int     Number of bytes queued
+ ******************************************************************************/
+static unsigned int uart_tx_put(const char *buf, unsigned int len, int overwrite)
+{
+    unsigned int room = uart_tx_room();
+    unsigned int drop;
+
+    if (len > room) {
+        if (overwrite) {
+            // Keep the newest bytes that fit in the whole ring
+            if (len > UART_TX_MASK) {
+                uart_tx_dropped += len - UART_TX_MASK;
+                buf += len - UART_TX_MASK;
+                len = UART_TX_MASK;
+            }
+
+            // Only the committed bytes can be dropped, not the ones a
+            // writer in progress is filling
+            drop = len - room;
+            if (drop > ((uart_tx_head - uart_tx_tail) & UART_TX_MASK)) {
+                drop = (uart_tx_head - uart_tx_tail) & UART_TX_MASK;
+                uart_tx_dropped += len - room - drop;
+                buf += len - room - drop;
+                len = room + drop;
+            }
+            uart_tx_dropped += drop;
+            uart_tx_tail = (uart_tx_tail + drop) & UART_TX_MASK;
+        } else {
+            uart_tx_dropped += len - room;
+            len = room;
+        }
+    }
+
+    if (len) {
+        uart_tx_copy(uart_tx_reserve(len), buf, len);
+        uart_tx_commit();
+    }
+
+    return len;
+}
+
+#ifdef CONFIG_DEBUG_UART_DMA
+
+/*******************************************************************************
+ * \brief   Start the DMA on the ring if it is idle and the ring not empty
+ *
+ *          The block sent is the contiguous part of the ring from the tail.
+ *          Must be called with interrupts disabled.
+ *
+ * \param void
+ * \return void
+ ******************************************************************************/
+static void uart_tx_kick( void )
+{
+    unsigned int tail = uart_tx_tail;
+    unsigned int head = uart_tx_head;
+
+    if (uart_tx_dma_len || tail == head) return;
+
+    uart_tx_dma_len = (head > tail ? head : CONFIG_DEBUG_UART_TX_SIZE) - tail;
+
+    DMA0SA = (unsigned long) (uintptr_t) &uart_tx_ring[tail];
+    DMA0SZ = uart_tx_dma_len;
+    DMA0CTL = DMADT_0 |         // Single transfers
+              DMASRCINCR_3 |    // Increment the source address
+              DMADSTINCR_0 |    // Fixed destination address
+              DMASRCBYTE |      // Byte to byte
+              DMADSTBYTE |
+              DMAIE |
+              DMAEN;
+
+    // The DMA triggers on a rising edge of UCTXIFG, which is already set
+    // while TXBUF is empty
+    UCA1IFG &= ~UCTXIFG;
+    UCA1IFG |= UCTXIFG;
+}
+
+/*******************************************************************************
+ * \brief   Release the block sent by the DMA and start the next one
+ *
+ *          Must be called with interrupts disabled.
+ *
+ * \param void
+ * \return void
+ ******************************************************************************/
+static void uart_tx_dma_done( void )
+{
+    uart_tx_tail = (uart_tx_tail + uart_tx_dma_len) & UART_TX_MASK;
+    uart_tx_dma_len = 0;
+
+    uart_tx_kick();
+}
+
+/*******************************************************************************
+ * \brief   Wait for the DMA block to be sent
+ *
+ *          Used when the DMA interrupt cannot run. Must be called with
+ *          interrupts disabled.
+ *
+ * \param void
+ * \return int     0 when there was nothing to send
+ ******************************************************************************/
+static int uart_tx_poll( void )
+{
+    if (!uart_tx_dma_len) return 0;
+
+    // DMAEN is cleared at the end of the block
+    while (DMA0CTL & DMAEN);
+
+    DMA0CTL &= ~DMAIFG;
+    uart_tx_dma_done();
+
+    return 1;
+}
+
+#else
+
+/*******************************************************************************
+ * \brief   Start the transmission if it is idle
+ *
+ *          UCTXIFG is set while TXBUF is empty, enabling the interrupt starts
+ *          the transmission. Must be called with interrupts disabled.
+ *
+ * \param void
+ * \return void
+ ******************************************************************************/
+static void uart_tx_kick( void )
+{
+    UCA1IE |= UCTXIE;
+}
+
+/*******************************************************************************
+ * \brief   Send the oldest byte of the transmit ring by polling
+ *
+ *          Used to make room when the TX interrupt cannot run. Must be called
+ *          with interrupts disabled.
+ *
+ * \param void
+ * \return int     0 when there was nothing to send
+ ******************************************************************************/
+static int uart_tx_poll( void )
+{
+    if (uart_tx_tail == uart_tx_head) return 0;
+
+    while ((UCA1IFG & UCTXIFG) == 0);
+
+    UCA1TXBUF = uart_tx_ring[uart_tx_tail];
+    uart_tx_tail = (uart_tx_tail + 1) & UART_TX_MASK;
+
+    return 1;
+}
+
+#endif /* CONFIG_DEBUG_UART_DMA */
+
+/*******************************************************************************
+ * \brief   Wait for the transmit ring to make progress
+ *
+ *          A task sleeps while the interrupts drain the ring. With interrupts
+ *          disabled (from an ISR or before the scheduler starts) the ring is
+ *          drained by polling.
+ *
+ * \param void
+ * \return int      0 when no progress can be made: interrupts are disabled
+ *                  and the ring holds only bytes of writers in progress
+ ******************************************************************************/
+static int uart_tx_wait( void )
+{
+    if ((__get_SR_register() & GIE) == 0) {
+        return uart_tx_poll();
+    } else if (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING) {
+#ifdef CONFIG_DEBUG_UART_DMA
+        xSemaphoreTake(uart_tx_done, 1);
+#else
+        vTaskDelay(1);
+#endif
+    }
+
+    return 1;
+}
+
+/*******************************************************************************
+ * \brief   Queue bytes on the UART without waiting
+ *
+ *          The bytes that do not fit in the transmit ring are dropped.
+ *
+ * \param const char *      Bytes to send
+ * \param unsigned int      Number of bytes
+ * \return unsigned int     Number of bytes queued
+ ******************************************************************************/
+unsigned int hal_debug_uart_write_nb(const char *buf, unsigned int len)
+{
+    unsigned int queued;
+    unsigned int sr;
+
+    HAL_LOCK(sr);
+    queued = uart_tx_put(buf, len, 0);
+    HAL_UNLOCK(sr);
+
+    return queued;
+}
+
+/*******************************************************************************
+ * \brief   Reserve space in the transmit ring if there is room
+ *
+ * \param unsigned int *    Set to the offset of the space in the ring
+ * \param unsigned int      Number of bytes
+ * \param unsigned int      Number of bytes to leave free in the ring
+ * \return int              0 when there is no room
+ ******************************************************************************/
+static int uart_tx_try_reserve(unsigned int *pos, unsigned int len, unsigned int keep)
+{
+    unsigned int sr;
+    int reserved = 0;
+
+    HAL_LOCK(sr);
+
+    if (len + keep <= uart_tx_room()) {
+        *pos = uart_tx_reserve(len);
+        reserved = 1;
+    }
+
+    HAL_UNLOCK(sr);
+
+    return reserved;
+}
+
+/*******************************************************************************
+ * \brief   Count bytes lost because the transmit ring was full
+ *
+ * \param unsigned int      Number of bytes
+ * \return void
+ ******************************************************************************/
+static void uart_tx_drop(unsigned int len)
+{
+    unsigned int sr;
+
+    HAL_LOCK(sr);
+    uart_tx_dropped += len;
+    HAL_UNLOCK(sr);
+}
+
+/*******************************************************************************
+ * \brief   Reserve space in the transmit ring, to fill it in place
+ *
+ *          The space is only reserved if keep bytes stay free in the ring.
+ *          With the UART_TX_BLOCK policy, a task or the code before the
+ *          scheduler starts waits for room, see uart_tx_wait(). An ISR never
+ *          waits. Once reserved, the space must be filled with
+ *          hal_debug_uart_set() and released with hal_debug_uart_commit().
+ *          Nothing reserved after it is sent before then, it must be filled
+ *          without waiting.
+ *
+ * \param unsigned int *    Set to the offset of the space in the ring
+ * \param unsigned int      Number of bytes
+ * \param unsigned int      Number of bytes to leave free in the ring
+ * \return unsigned int     Number of bytes reserved, len or 0
+ ******************************************************************************/
+unsigned int hal_debug_uart_reserve(unsigned int *pos, unsigned int len, unsigned int keep)
+{
+    while (!uart_tx_try_reserve(pos, len, keep)) {
+#if CONFIG_DEBUG_UART_TX_POLICY == UART_TX_BLOCK
+        if (len + keep > UART_TX_MASK) break;
+
+        if ((__get_SR_register() & GIE) == 0 &&
+            xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED) break;
+
+        if (uart_tx_wait()) continue;
+#endif
+        uart_tx_drop(len);
+        return 0;
+    }
+
+    return len;
+}
+
+/*******************************************************************************
+ * \brief   Fill a byte of the space reserved by hal_debug_uart_reserve()
+ *
+ *          Can be called with interrupts enabled.
+ *
+ * \param unsigned int      Offset of the space plus the offset of the byte,
+ *                          it may go past the end of the ring
+ * \param char              Byte to send
+ * \return void
+ ******************************************************************************/
+void hal_debug_uart_set(unsigned int pos, char c)
+{
+    uart_tx_ring[pos & UART_TX_MASK] = c;
+}
+
+/*******************************************************************************
+ * \brief   Release the space reserved by hal_debug_uart_reserve()
+ *
+ *          The whole space is sent, once the writers that reserved space
+ *          before are done as well.
+ *
+ * \param void
+ * \return void
+ ******************************************************************************/
+void hal_debug_uart_commit( void )
+{
+    unsigned int sr;
+
+    HAL_LOCK(sr);
+    uart_tx_commit();
+    HAL_UNLOCK(sr);
+}
+
+/*******************************************************************************
+ * \brief   Queue bytes on the UART without waiting, all of them or none
+ *
+ *          Safe from ISRs and before the scheduler starts.
+ *
+ * \param const char *      Bytes to send
+ * \param unsigned int      Number of bytes
+ * \return unsigned int     Number of bytes queued, len or 0
+ ******************************************************************************/
+unsigned int hal_debug_uart_write_frame(const char *buf, unsigned int len)
+{
+    unsigned int pos;
+
+    if (!uart_tx_try_reserve(&pos, len, 0)) {
+        uart_tx_drop(len);
+        return 0;
+    }
+
+    // The interrupts are only disabled to reserve the space and to commit it
+    uart_tx_copy(pos, buf, len);
+    hal_debug_uart_commit();
+
+    return len;
+}
+
+/*******************************************************************************
+ * \brief   Queue bytes on the UART, all of them or none, leaving room for
+ *          more urgent ones
+ *
+ *          Waits for room as hal_debug_uart_reserve() does.
+ *
+ * \param const char *      Bytes to send
+ * \param unsigned int      Number of bytes
+ * \param unsigned int      Number of bytes to leave free in the ring
+ * \return unsigned int     Number of bytes queued, len or 0
+ ******************************************************************************/
+unsigned int hal_debug_uart_write_frame_keep(const char *buf, unsigned int len, unsigned int keep)
+{
+    unsigned int pos;
+
+    if (!hal_debug_uart_reserve(&pos, len, keep)) return 0;
+
+    uart_tx_copy(pos, buf, len);
+    hal_debug_uart_commit();
+
+    return len;
 }
 
 /*******************************************************************************
- * \brief   Write a string to the UART TX buffer
+ * \brief   Write bytes to the UART transmit ring
  *
- * \param const char *  Text to write
+ *          What happens when the ring is full depends on
+ *          CONFIG_DEBUG_UART_TX_POLICY, see uart_tx_wait() for blocking.
+ *          When blocking, up to a whole ring of bytes is queued in one piece.
+ *
+ * \param const char *      Bytes to send
+ * \param unsigned int      Number of bytes
+ * \return unsigned int     Number of bytes queued
+ ******************************************************************************/
+static unsigned int uart_tx_write(const char *buf, unsigned int len)
+{
+    unsigned int queued;
+    unsigned int sr;
+
+#if CONFIG_DEBUG_UART_TX_POLICY == UART_TX_BLOCK
+    unsigned int chunk;
+    unsigned int total = 0;
+
+    while (len) {
+        chunk = (len > UART_TX_MASK) ? UART_TX_MASK : len;
+
+        HAL_LOCK(sr);
+        queued = (chunk <= uart_tx_room()) ? uart_tx_put(buf, chunk, 0) : 0;
+        HAL_UNLOCK(sr);
+
+        buf += queued;
+        len -= queued;
+        total += queued;
+
+        if (len && !queued && !uart_tx_wait()) {
+            // Nothing can drain the ring
+            uart_tx_drop(len);
+            break;
+        }
+    }
+
+    return total;
+#else
+    HAL_LOCK(sr);
+    queued = uart_tx_put(buf, len, CONFIG_DEBUG_UART_TX_POLICY == UART_TX_OVERWRITE);
+    HAL_UNLOCK(sr);
+
+    return queued;
+#endif
+}
+
+/*******************************************************************************
+ * \brief   Write a string to the UART transmit ring
+ *
+ * \param const char *      Text to write
+ * \return unsigned int     Number of bytes queued
+ ******************************************************************************/
+unsigned int hal_debug_uart_write(const char *buf)
+{
+    return uart_tx_write(buf, strlen(buf));
+}
+
+/*******************************************************************************
+ * \brief   Wait until the transmit ring is empty and the last byte is sent
+ *
+ * \param void
  * \return void
  ******************************************************************************/
-void hal_debug_uart_write(const char *buf)
+void hal_debug_uart_flush( void )
 {
-    // Send each character to the TX buffer
-    while (*buf) WRITE_DEBUG_UART(*buf++);
+    while (uart_tx_tail != uart_tx_head) uart_tx_wait();
 
     // Wait until transmit is done
     while (UCA1STAT & UCBUSY);
 }
 
+/*******************************************************************************
+ * \brief   Get the number of bytes dropped because the transmit ring was full
+ *
+ * \param void
+ * \return unsigned long    Number of bytes dropped since boot
+ ******************************************************************************/
+unsigned long hal_debug_uart_dropped( void )
+{
+    unsigned long dropped;
+    unsigned int sr;
+
+    HAL_LOCK(sr);
+    dropped = uart_tx_dropped;
+    HAL_UNLOCK(sr);
+
+    return dropped;
+}
+
+/*******************************************************************************
+ * \brief   Read the bytes received, without waiting
+ *
+ *          Only one task may read.
+ *
+ * \param char *            Buffer
+ * \param unsigned int      Size of the buffer
+ * \return unsigned int     Number of bytes read
+ ******************************************************************************/
+unsigned int hal_debug_uart_read(char *buf, unsigned int len)
+{
+    unsigned int tail = uart_rx_tail;
+    unsigned int head = uart_rx_head;
+    unsigned int n = 0;
+
+    while (n < len && tail != head) {
+        buf[n++] = uart_rx_ring[tail];
+        tail = (tail + 1) & UART_RX_MASK;
+    }
+
+    // Release the bytes to the interrupt once copied
+    uart_rx_tail = tail;
+
+    return n;
+}
+
+/*******************************************************************************
+ * \brief   Wait for the end of a line, or for the receive ring to fill up
+ *
+ *          Returns at once when one was received since the last call.
+ *
+ * \param void
+ * \return void
+ ******************************************************************************/
+void hal_debug_uart_wait_rx( void )
+{
+    xSemaphoreTake(uart_rx_ready, portMAX_DELAY);
+}
+
 /*******************************************************************************
  * \brief   ISR to handle events on the USCI_A1 pins.
  *
@@ -76,16 +789,69 @@ void hal_debug_uart_write(const char *buf)
  ******************************************************************************/
 void __attribute__ ( ( interrupt(USCI_A1_VECTOR) ) ) hal_debug_uart_isr( void )
 {
+    BaseType_t woken = pdFALSE;
+    unsigned int head;
+    unsigned int next;
+    char c;
+
     switch (__even_in_range(UCA1IV,4)) {
         case UART_NO_INTERRUPT:
             break;
         case UART_RX_IFG:
-            UCA1IFG  &= ~UCRXIFG;
-            UCA1TXBUF = UCA1RXBUF;
+            // Store the byte, the reader task does the rest. Reading RXBUF
+            // clears UCRXIFG. The byte is lost when the ring is full.
+            c = UCA1RXBUF;
+            head = uart_rx_head;
+            next = (head + 1) & UART_RX_MASK;
+
+            if (next != uart_rx_tail) {
+                uart_rx_ring[head] = c;
+                uart_rx_head = next;
+            }
+
+            // Only wake the reader once there is something to act on: the
+            // end of a line, or a ring that is full with this byte
+            if (c == '\r' || c == '\n' || ((uart_rx_head + 1) & UART_RX_MASK) == uart_rx_tail)
+                xSemaphoreGiveFromISR(uart_rx_ready, &woken);
             break;
         case UART_TX_IFG:
+            if (uart_tx_tail == uart_tx_head) {
+                // Ring drained. Reading UCA1IV cleared UCTXIFG while TXBUF is
+                // empty, set it back so that the next kick fires the interrupt
+                UCA1IE &= ~UCTXIE;
+                UCA1IFG |= UCTXIFG;
+            } else {
+                UCA1TXBUF = uart_tx_ring[uart_tx_tail];
+                uart_tx_tail = (uart_tx_tail + 1) & UART_TX_MASK;
+            }
             break;
         default:
             break;
     }
+
+    portYIELD_FROM_ISR(woken);
+}
+
+#ifdef CONFIG_DEBUG_UART_DMA
+/*******************************************************************************
+ * \brief   ISR to handle the end of the DMA blocks sent on the debug UART
+ *
+ * \param void
+ * \return void
+ ******************************************************************************/
+void __attribute__ ( ( interrupt(DMA_VECTOR) ) ) hal_debug_uart_dma_isr( void )
+{
+    BaseType_t woken = pdFALSE;
+
+    switch (__even_in_range(DMAIV,16)) {
+        case 2:
+            uart_tx_dma_done();
+            xSemaphoreGiveFromISR(uart_tx_done, &woken);
+            break;
+        default:
+            break;
+    }
+
+    portYIELD_FROM_ISR(woken);
 }
+#endif /* CONFIG_DEBUG_UART_DMA */
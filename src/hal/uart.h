@@ -12,16 +12,115 @@
 #define UART_RX_IFG         ( 2 )
 #define UART_TX_IFG         ( 4 )
 
+// SMCLK runs from the DCO at the CPU frequency, see hal_setup_clock_pmm()
+#if CONFIG_CPU_CLOCK_HZ > CONFIG_CPU_CLOCK_LIMIT_KHZ * 1000UL
+    #define UART_SMCLK_HZ       ( CONFIG_CPU_CLOCK_LIMIT_KHZ * 1000UL )
+#else
+    #define UART_SMCLK_HZ       ( CONFIG_CPU_CLOCK_HZ )
+#endif
+
+// Clock of the baud rate generator. ACLK keeps the UART running in the
+// deep low power modes but needs a prescaler of at least 3.
+#if CONFIG_DEBUG_UART_BAUD * 3 <= CONFIG_XT1_CLOCK_HZ
+    #define UART_BRCLK_HZ       ( CONFIG_XT1_CLOCK_HZ )
+    #define UART_BRCLK_SEL      UCSSEL__ACLK
+#else
+    #define UART_BRCLK_HZ       ( UART_SMCLK_HZ )
+    #define UART_BRCLK_SEL      UCSSEL__SMCLK
+    #define UART_BRCLK_SMCLK
+#endif
+
+// Division factor N = BRCLK / baud, rounded to 1/16 and to 1/8
+#define UART_N_X16              ( ( 2 * 16 * UART_BRCLK_HZ + CONFIG_DEBUG_UART_BAUD ) / ( 2 * CONFIG_DEBUG_UART_BAUD ) )
+#define UART_N_X8               ( ( 2 * 8 * UART_BRCLK_HZ + CONFIG_DEBUG_UART_BAUD ) / ( 2 * CONFIG_DEBUG_UART_BAUD ) )
+#define UART_N                  ( ( 2 * UART_BRCLK_HZ + CONFIG_DEBUG_UART_BAUD ) / ( 2 * CONFIG_DEBUG_UART_BAUD ) )
+
+// Baud rate generator settings
+// @see page 905, 906 of slau208n.pdf
+#if UART_N_X16 >= 16 * 16
+    // Oversampling mode, N >= 16
+    // UCBRx = INT(N / 16), UCBRFx = round((N / 16 - INT(N / 16)) * 16)
+    #define UART_OS16           ( UCOS16 )
+    #define UART_BR             ( UART_N / 16 )
+    #define UART_BRS            ( 0 )
+    #define UART_BRF            ( UART_N % 16 )
+    #define UART_DIVIDER_X8     ( 8 * UART_N )
+#else
+    // Low frequency mode
+    // UCBRx = INT(N), UCBRSx = round((N - INT(N)) * 8)
+    #define UART_OS16           ( 0 )
+    #define UART_BR             ( UART_N_X8 / 8 )
+    #define UART_BRS            ( UART_N_X8 % 8 )
+    #define UART_BRF            ( 0 )
+    #define UART_DIVIDER_X8     ( UART_N_X8 )
+#endif
+
+#if UART_BR < 1
+    #error CONFIG_DEBUG_UART_BAUD is too high for the clock of the UART
+#endif
+
+// SMCLK follows the CPU frequency, the settings are computed again at each
+// change, see hal_clock_set()
+#if defined(UART_BRCLK_SMCLK) && defined(CONFIG_CPU_CLOCK_SCALING) && \
+    CONFIG_CPU_CLOCK_LOW_HZ < 16UL * CONFIG_DEBUG_UART_BAUD
+    #error CONFIG_DEBUG_UART_BAUD is too high for CONFIG_CPU_CLOCK_LOW_HZ
+#endif
+
+// Reject a mean baud rate error above 2 %, the modulation spreads the
+// rounding of N over the bits of a character
+#if ( 100 * 8 * UART_BRCLK_HZ > 102 * CONFIG_DEBUG_UART_BAUD * UART_DIVIDER_X8 ) || \
+    ( 100 * 8 * UART_BRCLK_HZ < 98 * CONFIG_DEBUG_UART_BAUD * UART_DIVIDER_X8 )
+    #error CONFIG_DEBUG_UART_BAUD cannot be generated within 2 % from the UART clock
+#endif
+
+// Polled write, bypasses the transmit ring
 #define WRITE_DEBUG_UART(_x) {UCA1TXBUF = _x; while ((UCA1IFG & UCTXIFG) == 0);}
 
+// Behaviour of hal_debug_uart_write() when the transmit ring is full
+#define UART_TX_DROP        ( 0 )   // Drop the bytes that do not fit
+#define UART_TX_BLOCK       ( 1 )   // Wait for the ISR to make room
+#define UART_TX_OVERWRITE   ( 2 )   // Drop the oldest pending bytes
+
+#if (CONFIG_DEBUG_UART_TX_SIZE & (CONFIG_DEBUG_UART_TX_SIZE - 1)) != 0
+    #error CONFIG_DEBUG_UART_TX_SIZE must be a power of 2
+#endif
+
+#if (CONFIG_DEBUG_UART_RX_SIZE & (CONFIG_DEBUG_UART_RX_SIZE - 1)) != 0
+    #error CONFIG_DEBUG_UART_RX_SIZE must be a power of 2
+#endif
+
+#ifdef CONFIG_DEBUG_UART_DMA
+    // The oldest bytes of the ring are the ones the DMA is reading
+    #if CONFIG_DEBUG_UART_TX_POLICY == UART_TX_OVERWRITE
+        #error CONFIG_DEBUG_UART_DMA cannot be used with the overwrite policy
+    #endif
+
+    // DMA trigger of UCA1TXIFG
+    // @see page 24 of msp430f5438.pdf
+    #define UART_DMA_TRIGGER    DMA0TSEL_21
+#endif
+
 /*******************************************************************************
  * Prototypes
  ******************************************************************************/
 
 void hal_init_debug_uart( void );
-void hal_debug_uart_write(const char *buf);
+unsigned int hal_debug_uart_write(const char *buf);
+unsigned int hal_debug_uart_write_nb(const char *buf, unsigned int len);
+unsigned int hal_debug_uart_write_frame(const char *buf, unsigned int len);
+unsigned int hal_debug_uart_write_frame_keep(const char *buf, unsigned int len, unsigned int keep);
+unsigned int hal_debug_uart_reserve(unsigned int *pos, unsigned int len, unsigned int keep);
+void hal_debug_uart_set(unsigned int pos, char c);
+void hal_debug_uart_commit( void );
+void hal_debug_uart_flush( void );
+unsigned long hal_debug_uart_dropped( void );
+unsigned int hal_debug_uart_read(char *buf, unsigned int len);
+void hal_debug_uart_wait_rx( void );
 
 void __attribute__ ( ( interrupt(USCI_A1_VECTOR) ) ) hal_debug_uart_isr( void );
+#ifdef CONFIG_DEBUG_UART_DMA
+void __attribute__ ( ( interrupt(DMA_VECTOR) ) ) hal_debug_uart_dma_isr( void );
+#endif
 
 #endif /* HAL_UART_H */
 
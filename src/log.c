@@ -1,19 +1,92 @@
+#include <msp430.h>
 #include <stdarg.h>
+#include <stdint.h>
 
 #include "FreeRTOS.h"
+#include "task.h"
 #include "semphr.h"
 
+#include "hal/misc.h"
+#include "hal/timestamp.h"
 #include "utils/vuprintf.h"
 #include "log.h"
+#include "mux.h"
 
 
 #ifdef CONFIG_LOGGING
 
+// Most verbose level sent at runtime, see the slog_xxx() macros
+unsigned char slog_level = CONFIG_LOG_LEVEL;
+
+// Sequence number of the next record, and number of records lost since the
+// last one sent, reported by the next one. Changed under HAL_LOCK().
+static unsigned int slog_seq;
+static unsigned int slog_dropped;
+
+#ifdef CONFIG_LOGGING_BINARY
+
+// Binary record, in 16-bit little endian words:
+//  - LOG_RECORD_SYNC in the low byte, length of the record in the high byte
+//  - address of the format string (2 words)
+//  - hal_timestamp() (2 words)
+//  - sequence number
+//  - number of records lost before this one
+//  - arguments: 1 word for %c %i %u %x %q, 2 words for %l %n %lx %lq
+//    and the address of a %s string
+#define LOG_RECORD_SYNC     ( 0xa5 )
+#define LOG_RECORD_HEADER   ( 7 )
+#define LOG_RECORD_ARGS     ( 8 )
+
+#ifdef CONFIG_DEBUG_UART_MUX
+    // A record is sent as one message of the trace channel
+    #if 2 * (LOG_RECORD_HEADER + 2 * LOG_RECORD_ARGS) > MUX_PAYLOAD_MAX
+        #error A log record does not fit in a frame
+    #endif
+
+    #define slog_write_record(_buf, _len)   mux_write(MUX_CHANNEL_TRACE, _buf, _len)
+#else
+    #define slog_write_record(_buf, _len)   hal_debug_uart_write_frame(_buf, _len)
+#endif
+
+#else
+
+// Longest line sent, the end of longer lines is cut
+#define LOG_LINE_MAX        ( 80 )
+
+// Longest line header, "#65535 131071.999999 (65535 dropped) "
+#define LOG_HEADER_MAX      ( 40 )
+
+#ifdef CONFIG_DEBUG_UART_MUX
+    // A line is sent as one frame of the text channel, so that a frame
+    // dropped or sent from an ISR never cuts a line
+    #if LOG_HEADER_MAX + LOG_LINE_MAX + 2 > MUX_PAYLOAD_MAX
+        #error A log line does not fit in a frame
+    #endif
+
+    typedef mux_frame_t slog_out_t;
+
+    #define slog_open(_out, _len)   mux_open(_out, MUX_CHANNEL_TEXT, _len)
+    #define slog_putc(_out, _c)     mux_putc(_out, _c)
+    #define slog_close(_out)        mux_close(_out)
+#else
+    // A line is written straight into the UART transmit ring, at an offset
+    typedef unsigned int slog_out_t;
+
+    #define slog_open(_out, _len)   hal_debug_uart_reserve(_out, _len, 0)
+    #define slog_putc(_out, _c)     hal_debug_uart_set((*(_out))++, _c)
+    #define slog_close(_out)        hal_debug_uart_commit()
+#endif
+
+// Line being formatted in the space reserved for it
+typedef struct {
+    slog_out_t out;         // Output of the line
+    unsigned int left;      // Characters left before the EOL characters
+} slog_slot_t;
+
 // Mutex for the debug UART interface access
 static xSemaphoreHandle uart_logging_mutex;
 
-// Text buffer used to print on the UART interface
-static char logging_buffer[50];
+#endif /* CONFIG_LOGGING_BINARY */
 
 
 /*******************************************************************************
@@ -25,6 +98,10 @@ static char logging_buffer[50];
  ******************************************************************************/
 void enable_logging( void )
 {
+#ifdef CONFIG_LOGGING_BINARY
+    // Records are queued in one piece, no lock is needed
+    hal_init_debug_uart();
+#else
     if(!uart_logging_mutex) {
         // Enable the debug UART interface on P10.4 and P10.5
         hal_init_debug_uart();
@@ -33,34 +110,375 @@ void enable_logging( void )
         uart_logging_mutex = xSemaphoreCreateMutex();
         xSemaphoreGive(uart_logging_mutex);
     }
+#endif
 }
 
+/*******************************************************************************
+ * \brief   Number a new record
+ *
+ * \param unsigned int *    Set to the number of records lost before it
+ * \return unsigned int     Sequence number of the record
+ ******************************************************************************/
+static unsigned int slog_begin( unsigned int *dropped )
+{
+    unsigned int seq;
+    unsigned int sr;
+
+    HAL_LOCK(sr);
+    seq = slog_seq++;
+    *dropped = slog_dropped;
+    slog_dropped = 0;
+    HAL_UNLOCK(sr);
+
+    return seq;
+}
+
+/*******************************************************************************
+ * \brief   Count a record that could not be sent
+ *
+ *          The records lost it was to report are reported by the next one.
+ *
+ * \param unsigned int  Number of records lost before it
+ * \return void
+ ******************************************************************************/
+static void slog_lost( unsigned int dropped )
+{
+    unsigned int sr;
+
+    HAL_LOCK(sr);
+    dropped += slog_dropped + 1;
+    slog_dropped = (dropped > slog_dropped) ? dropped : 0xffff;
+    HAL_UNLOCK(sr);
+}
+
+#ifdef CONFIG_LOGGING_BINARY
+
+/*******************************************************************************
+ * \brief   Send a binary log record, the formatting is done on the host
+ *
+ *          Only the address of the format string and the raw arguments are
+ *          recorded, the format and the %s strings must be constants so that
+ *          the host can read them from the ELF file. The record is dropped
+ *          when it does not fit in the UART transmit ring. Safe from ISRs.
+ *
+ * \param char *                    Format string
+ * \param const uprintf_plan_t *    Conversions of the format, or NULL to
+ *                                  parse it
+ * \param va_list                   Argument list
+ * \return void
+ ******************************************************************************/
+static void slog_record( const char *fmt, const uprintf_plan_t *plan, va_list va )
+{
+    unsigned int rec[LOG_RECORD_HEADER + LOG_RECORD_ARGS];
+    unsigned int *arg = &rec[LOG_RECORD_HEADER];
+    unsigned int *end = &rec[LOG_RECORD_HEADER + LOG_RECORD_ARGS];
+    const char *f = fmt;
+    unsigned long value;
+    unsigned long ts = hal_timestamp();
+    unsigned int dropped;
+    unsigned int seq = slog_begin(&dropped);
+    unsigned char k = 0;
+    unsigned char type;
+    char c;
+
+    for (;;) {
+        if (plan) {
+            if (k == plan->count) break;
+            type = plan->arg[k++];
+        } else {
+            // Only the conversions are looked at, in the same way as vuprintf()
+            while ((c = *f++) && c != '%');
+            if (!c) break;
+
+            // Flags, width and precision are applied on the host
+            do c = *f++; while (c == '-' || c == '.' || (c >= '0' && c <= '9'));
+
+            // %lx and %lq take a long, like %l
+            if (c == 'l' && (*f == 'x' || *f == 'q')) f++;
+
+            switch (c) {
+                case 'c':
+                case 'i':
+                case 'u':
+                case 'x':
+                case 'q':
+                    type = UPRINTF_ARG_WORD;
+                    break;
+                case 'l':
+                case 'n':
+                    type = UPRINTF_ARG_LONG;
+                    break;
+                case 's':
+                    type = UPRINTF_ARG_STR;
+                    break;
+                case 0:
+                    goto full;
+                default:
+                    type = UPRINTF_ARG_NONE;
+                    break;
+            }
+        }
+
+        switch (type) {
+            case UPRINTF_ARG_WORD:
+                if (arg == end) goto full;
+                *arg++ = va_arg(va, unsigned int);
+                break;
+            case UPRINTF_ARG_LONG:
+            case UPRINTF_ARG_STR:
+                if (arg + 2 > end) goto full;
+                if (type == UPRINTF_ARG_STR) value = (uintptr_t) va_arg(va, char*);
+                else value = va_arg(va, unsigned long);
+                *arg++ = value;
+                *arg++ = value >> 16;
+                break;
+            default:
+                break;
+        }
+    }
+
+full:
+    rec[0] = LOG_RECORD_SYNC | ((unsigned int) ((char *) arg - (char *) rec) << 8);
+    rec[1] = (uintptr_t) fmt;
+    rec[2] = (unsigned long) (uintptr_t) fmt >> 16;
+    rec[3] = ts;
+    rec[4] = ts >> 16;
+    rec[5] = seq;
+    rec[6] = dropped;
+
+    if (!slog_write_record((const char *) rec, (char *) arg - (char *) rec))
+        slog_lost(dropped);
+
+    // Before the scheduler starts, the record is sent by polling
+    if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED) hal_debug_uart_flush();
+}
+
+#else
+
+/*******************************************************************************
+ * \brief   Format the header of a line into a sink
+ *
+ * \param uprintf_putc_t            Function called for each character
+ * \param void *                    Context passed to the function
+ * \param const uprintf_plan_t *    Format of the header
+ * \param ...                       Argument list
+ * \return unsigned int             Length of the header
+ ******************************************************************************/
+static unsigned int slog_header( uprintf_putc_t putc, void *ctx, const uprintf_plan_t *plan, ... )
+{
+    unsigned int len;
+    va_list va;
+    va_start(va,plan);
+    len = vuprintf_plan_sink(putc, ctx, LOG_HEADER_MAX, plan, va);
+    va_end(va);
+
+    return len;
+}
+
+/*******************************************************************************
+ * \brief   Format a line, without its EOL characters, into a sink
+ *
+ *          The line starts with its sequence number, the timestamp in
+ *          seconds and, after records were lost, how many of them.
+ *
+ * \param uprintf_putc_t            Function called for each character
+ * \param void *                    Context passed to the function
+ * \param unsigned int              Sequence number
+ * \param unsigned long             hal_timestamp() of the record
+ * \param unsigned int              Number of records lost before it
+ * \param char *                    Format string
+ * \param const uprintf_plan_t *    Conversions of the format, or NULL to
+ *                                  parse it
+ * \param va_list                   Argument list
+ * \return unsigned int             Length of the line, up to
+ *                                  LOG_HEADER_MAX + LOG_LINE_MAX
+ ******************************************************************************/
+static unsigned int slog_format( uprintf_putc_t putc, void *ctx, unsigned int seq, unsigned long ts, unsigned int dropped,
+                                 const char *fmt, const uprintf_plan_t *plan, va_list va )
+{
+    unsigned int len;
+    unsigned long sec = ts / HAL_TIMESTAMP_HZ;
+
+    // Microseconds, 10^6 / 64 keeps the product in 32 bits
+    unsigned long usec = (ts % HAL_TIMESTAMP_HZ) * 15625UL / (HAL_TIMESTAMP_HZ / 64);
+
+    if (dropped) {
+        UPRINTF_PLAN(header, "#%u %n.%06n (%u dropped) ", seq, sec, usec, dropped);
+        len = slog_header(putc, ctx, &header, seq, sec, usec, dropped);
+    } else {
+        UPRINTF_PLAN(header, "#%u %n.%06n ", seq, sec, usec);
+        len = slog_header(putc, ctx, &header, seq, sec, usec);
+    }
+
+    if (plan)
+        len += vuprintf_plan_sink(putc, ctx, LOG_LINE_MAX, plan, va);
+    else
+        len += vuprintf_sink(putc, ctx, LOG_LINE_MAX, fmt, va);
+
+    return len;
+}
+
+/*******************************************************************************
+ * \brief   Formatter sink discarding the characters, to count them
+ *
+ * \param void *    Unused
+ * \param char      Character
+ * \return void
+ ******************************************************************************/
+static void slog_skip( void *ctx, char c )
+{
+    (void) ctx;
+    (void) c;
+}
+
+/*******************************************************************************
+ * \brief   Formatter sink writing to the space reserved for a line
+ *
+ * \param void *    slog_slot_t of the line
+ * \param char      Character to write
+ * \return void
+ ******************************************************************************/
+static void slog_put( void *ctx, char c )
+{
+    slog_slot_t *slot = ctx;
+
+    if (slot->left) {
+        slot->left--;
+        slog_putc(&slot->out, c);
+    }
+}
+
+/*******************************************************************************
+ * \brief   Format a line straight into the UART transmit ring
+ *
+ *          The line is formatted a first time only to count its characters,
+ *          then into the space reserved for it, in a frame of the text
+ *          channel with CONFIG_DEBUG_UART_MUX. Lines are thus queued whole
+ *          or dropped, never cut or mixed with a line logged from an ISR, and
+ *          no line buffer is needed. Tasks wait for room with the
+ *          UART_TX_BLOCK policy, ISRs never wait. Safe from ISRs and before
+ *          the scheduler starts, tasks must hold the mutex.
+ *
+ * \param unsigned int              Sequence number
+ * \param unsigned long             hal_timestamp() of the record
+ * \param unsigned int              Number of records lost before it
+ * \param char *                    Format string
+ * \param const uprintf_plan_t *    Conversions of the format, or NULL to
+ *                                  parse it
+ * \param va_list                   Argument list
+ * \return int                      0 when the line was dropped
+ ******************************************************************************/
+static int slog_send( unsigned int seq, unsigned long ts, unsigned int dropped,
+                      const char *fmt, const uprintf_plan_t *plan, va_list va )
+{
+    slog_slot_t slot;
+    unsigned int len;
+    va_list count;
+
+    va_copy(count, va);
+    len = slog_format(slog_skip, NULL, seq, ts, dropped, fmt, plan, count);
+    va_end(count);
+
+    if (!slog_open(&slot.out, len + 2)) return 0;
+
+    slot.left = len;
+    slog_format(slog_put, &slot, seq, ts, dropped, fmt, plan, va);
+
+    // A %s string shortened between the two passes
+    while (slot.left) slog_put(&slot, ' ');
+
+    slog_putc(&slot.out, '\r');
+    slog_putc(&slot.out, '\n');
+    slog_close(&slot.out);
+
+    return 1;
+}
+
+/*******************************************************************************
+ * \brief   Send a formatted line to the logging interfaces
+ *
+ *          Tasks take turns under a mutex and are numbered once they hold
+ *          it, so that their lines are sent in sequence order. From an ISR,
+ *          or with the interrupts disabled, no mutex can be taken: the line
+ *          is queued without waiting and dropped when the transmit ring is
+ *          full. Before the scheduler starts, the line is sent by polling
+ *          before returning. The timestamp is the time of the call.
+ *
+ * \param char *                    Format string
+ * \param const uprintf_plan_t *    Conversions of the format, or NULL to
+ *                                  parse it
+ * \param va_list                   Argument list
+ * \return void
+ ******************************************************************************/
+static void slog_line( const char *fmt, const uprintf_plan_t *plan, va_list va )
+{
+    unsigned long ts = hal_timestamp();
+    unsigned int dropped;
+    unsigned int seq;
+    int sent;
+
+    if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED) {
+        seq = slog_begin(&dropped);
+        sent = slog_send(seq, ts, dropped, fmt, plan, va);
+        hal_debug_uart_flush();
+    } else if ((__get_SR_register() & GIE) == 0) {
+        seq = slog_begin(&dropped);
+        sent = slog_send(seq, ts, dropped, fmt, plan, va);
+    } else {
+        // Take the mutex
+        xSemaphoreTake(uart_logging_mutex, portMAX_DELAY);
+
+        seq = slog_begin(&dropped);
+        sent = slog_send(seq, ts, dropped, fmt, plan, va);
+
+        // Give the mutex
+        xSemaphoreGive(uart_logging_mutex);
+    }
+
+    if (!sent) slog_lost(dropped);
+}
+
+#endif /* CONFIG_LOGGING_BINARY */
+
+#ifdef CONFIG_LOGGING_BINARY
+    #define slog_emit       slog_record
+#else
+    #define slog_emit       slog_line
+#endif
+
 /*******************************************************************************
  * \brief   Send the result of a formatted string to the logging interfaces.
  *
+ *          The format is parsed at runtime and not checked, prefer the
+ *          slog_xxx() macros with a constant format.
+ *
  * \param char *    Format string
  * \param ...       Argument list
  * \return void
  ******************************************************************************/
 void slog( const char *fmt, ... )
 {
-    // Take the mutex
-    xSemaphoreTake(uart_logging_mutex, portMAX_DELAY);
-
     va_list va;
     va_start(va,fmt);
-    vuprintf(logging_buffer, fmt, va);
+    slog_emit(fmt, NULL, va);
     va_end(va);
+}
 
-    // Write the string to the UART debug interface
-    hal_debug_uart_write(logging_buffer);
-
-    // Add EOL characters
-    WRITE_DEBUG_UART('\r');
-    WRITE_DEBUG_UART('\n');
-
-    // Give the mutex
-    xSemaphoreGive(uart_logging_mutex);
+/*******************************************************************************
+ * \brief   Send a log message with a format parsed at compile time
+ *
+ *          Called by the slog_xxx() macros, see UPRINTF_PLAN().
+ *
+ * \param const uprintf_plan_t *    Format and its conversions
+ * \param ...                       Argument list
+ * \return void
+ ******************************************************************************/
+void slog_plan( const uprintf_plan_t *plan, ... )
+{
+    va_list va;
+    va_start(va,plan);
+    slog_emit(plan->fmt, plan, va);
+    va_end(va);
 }
 
 #endif /* CONFIG_LOGGING */
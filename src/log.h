@@ -4,16 +4,92 @@
 #include "config.h"
 
 #include "hal/uart.h"
+#include "utils/vuprintf.h"
 
 
+/*******************************************************************************
+ * Macros
+ ******************************************************************************/
+
+#define LOG_LEVEL_NONE      ( 0 )
+#define LOG_LEVEL_ERROR     ( 1 )
+#define LOG_LEVEL_WARNING   ( 2 )
+#define LOG_LEVEL_INFO      ( 3 )
+#define LOG_LEVEL_DEBUG     ( 4 )
+#define LOG_LEVEL_TRACE     ( 5 )
+
+// Tag of the messages of a file, to define before including log.h,
+// it must be a string literal
+#ifndef LOG_MODULE
+    #define LOG_MODULE      "-"
+#endif
+
+// Most verbose level compiled in for a file, to define before including
+// log.h, the calls above it and their format strings are removed
+#ifndef LOG_MODULE_LEVEL
+    #define LOG_MODULE_LEVEL    CONFIG_LOG_LEVEL
+#endif
+
+#ifdef CONFIG_LOGGING
+
+// The level and the module tag are prepended to the format string at compile
+// time, the only runtime cost of a filtered call is a compare with slog_level.
+// The format is parsed and checked against the arguments by the compiler,
+// see UPRINTF_PLAN(). Usable from ISRs and before the scheduler starts.
+#define SLOG_AT(_level, _tag, _fmt, ...) \
+    do { \
+        UPRINTF_PLAN(slog_plan_, _tag "/" LOG_MODULE ": " _fmt, ##__VA_ARGS__); \
+        if ((_level) <= slog_level) slog_plan(&slog_plan_, ##__VA_ARGS__); \
+    } while (0)
+
+#else
+
+#define SLOG_AT(_level, _tag, _fmt, ...) do {} while (0)
+
+#endif /* CONFIG_LOGGING */
+
+#if LOG_MODULE_LEVEL >= LOG_LEVEL_ERROR
+    #define slog_error(_fmt, ...)   SLOG_AT(LOG_LEVEL_ERROR, "E", _fmt, ##__VA_ARGS__)
+#else
+    #define slog_error(_fmt, ...)   do {} while (0)
+#endif
+
+#if LOG_MODULE_LEVEL >= LOG_LEVEL_WARNING
+    #define slog_warning(_fmt, ...) SLOG_AT(LOG_LEVEL_WARNING, "W", _fmt, ##__VA_ARGS__)
+#else
+    #define slog_warning(_fmt, ...) do {} while (0)
+#endif
+
+#if LOG_MODULE_LEVEL >= LOG_LEVEL_INFO
+    #define slog_info(_fmt, ...)    SLOG_AT(LOG_LEVEL_INFO, "I", _fmt, ##__VA_ARGS__)
+#else
+    #define slog_info(_fmt, ...)    do {} while (0)
+#endif
+
+#if LOG_MODULE_LEVEL >= LOG_LEVEL_DEBUG
+    #define slog_debug(_fmt, ...)   SLOG_AT(LOG_LEVEL_DEBUG, "D", _fmt, ##__VA_ARGS__)
+#else
+    #define slog_debug(_fmt, ...)   do {} while (0)
+#endif
+
+#if LOG_MODULE_LEVEL >= LOG_LEVEL_TRACE
+    #define slog_trace(_fmt, ...)   SLOG_AT(LOG_LEVEL_TRACE, "T", _fmt, ##__VA_ARGS__)
+#else
+    #define slog_trace(_fmt, ...)   do {} while (0)
+#endif
+
 /*******************************************************************************
  * Prototypes
  ******************************************************************************/
 
 #ifdef CONFIG_LOGGING
 
+// Most verbose level sent at runtime
+extern unsigned char slog_level;
+
 void enable_logging( void );
 void slog( const char *fmt, ... );
+void slog_plan( const uprintf_plan_t *plan, ... );
 
 #else
 
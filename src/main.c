@@ -12,9 +12,12 @@
 
 // HAL includes
 #include "hal/misc.h"
+#include "hal/power.h"
 #include "hal/timer.h"
+#include "hal/timestamp.h"
 
 #include "log.h"
+#include "shell.h"
 
 
 // Prototypes
@@ -40,6 +43,14 @@ int main( void )
     // Initialize the TimerA0
     hal_timer_a0_init();
 
+    // Start the monotonic timestamp on TimerA1
+    hal_timestamp_init();
+
+#ifdef CONFIG_SHELL
+    // Run the commands received on the debug UART
+    shell_init();
+#endif
+
     // Start the scheduler
     vTaskStartScheduler();
 
@@ -70,9 +81,9 @@ void vApplicationSetupTimerInterrupt( void )
 
 void vApplicationIdleHook( void )
 {
-    // Called on each iteration of the idle task. In this case the idle task
-    // just enters a low(ish) power mode. */
-    __bis_SR_register( LPM1_bits + GIE );
+    // Called on each iteration of the idle task. The idle task enters the
+    // deepest low power mode keeping the clocks required by the drivers.
+    hal_power_idle();
 }
 
 void vApplicationMallocFailedHook( void )
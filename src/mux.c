@@ -0,0 +1,193 @@
+#include <msp430.h>
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+
+#include "hal/misc.h"
+#include "hal/uart.h"
+#include "utils/crc16.h"
+#include "mux.h"
+
+
+#ifdef CONFIG_DEBUG_UART_MUX
+
+#if MUX_PAYLOAD_MAX + 3 > 254
+    #error A frame must be COBS encoded in a single block, see mux_encode()
+#endif
+
+#if CONFIG_DEBUG_UART_TX_SIZE / 2 + MUX_FRAME_MAX >= CONFIG_DEBUG_UART_TX_SIZE
+    #error CONFIG_DEBUG_UART_TX_SIZE is too small for a bulk frame
+#endif
+
+// Room a frame must leave in the transmit ring for the more urgent channels:
+// the shell replies first, then the trace records, the log lines and last
+// the data dumps
+static const unsigned int mux_keep[MUX_CHANNELS] = {
+    CONFIG_DEBUG_UART_TX_SIZE / 4,      // MUX_CHANNEL_TEXT
+    CONFIG_DEBUG_UART_TX_SIZE / 8,      // MUX_CHANNEL_TRACE
+    0,                                  // MUX_CHANNEL_RPC
+    CONFIG_DEBUG_UART_TX_SIZE / 2,      // MUX_CHANNEL_BULK
+};
+
+// Frames sent and dropped on each channel, changed under HAL_LOCK()
+static unsigned long mux_sent[MUX_CHANNELS];
+static unsigned long mux_dropped[MUX_CHANNELS];
+
+
+/*******************************************************************************
+ * \brief   COBS encode a byte of a frame
+ *
+ *          A 0 byte is replaced by the distance to the next one, or to the
+ *          end, and the first byte of the frame by the distance to the first
+ *          0, so the code of the current block is only written once its end
+ *          is known. This is COBS as long as the frame is shorter than 254
+ *          bytes.
+ *
+ * \param mux_frame_t *     Frame
+ * \param char              Byte to encode
+ * \return void
+ ******************************************************************************/
+static void mux_encode( mux_frame_t *frame, char c )
+{
+    if (c == 0) {
+        hal_debug_uart_set(frame->code, frame->pos - frame->code);
+        frame->code = frame->pos;
+    } else {
+        hal_debug_uart_set(frame->pos, c);
+    }
+
+    frame->pos++;
+}
+
+/*******************************************************************************
+ * \brief   Start a frame, encoded straight into the UART transmit ring
+ *
+ *          The whole frame is reserved, the payload must then be given with
+ *          mux_putc(), exactly len bytes of it, and the frame ended with
+ *          mux_close() without waiting: nothing queued after it is sent
+ *          before then. A frame that does not fit in the transmit ring, once
+ *          the room of the more urgent channels is kept, waits or is dropped
+ *          as a whole, see hal_debug_uart_reserve(). Safe from ISRs and
+ *          before the scheduler starts.
+ *
+ * \param mux_frame_t *     Frame
+ * \param unsigned char     Channel, MUX_CHANNEL_xxx
+ * \param unsigned int      Length of the payload, up to MUX_PAYLOAD_MAX
+ * \return int              0 when the frame was dropped
+ ******************************************************************************/
+int mux_open( mux_frame_t *frame, unsigned char channel, unsigned int len )
+{
+    unsigned int sr;
+
+    if (!hal_debug_uart_reserve(&frame->pos, MUX_FRAME_SIZE(len), mux_keep[channel])) {
+        HAL_LOCK(sr);
+        mux_dropped[channel]++;
+        HAL_UNLOCK(sr);
+
+        return 0;
+    }
+
+    frame->code = frame->pos++;
+    frame->crc = CRC16_INIT;
+    frame->channel = channel;
+    mux_putc(frame, channel);
+
+    return 1;
+}
+
+/*******************************************************************************
+ * \brief   Add a byte to the payload of a frame started by mux_open()
+ *
+ * \param mux_frame_t *     Frame
+ * \param char              Byte of the payload
+ * \return void
+ ******************************************************************************/
+void mux_putc( mux_frame_t *frame, char c )
+{
+    frame->crc = crc16(frame->crc, &c, 1);
+    mux_encode(frame, c);
+}
+
+/*******************************************************************************
+ * \brief   End a frame started by mux_open() and queue it
+ *
+ * \param mux_frame_t *     Frame
+ * \return void
+ ******************************************************************************/
+void mux_close( mux_frame_t *frame )
+{
+    uint16_t crc = frame->crc;
+    unsigned int sr;
+
+    mux_encode(frame, crc);
+    mux_encode(frame, crc >> 8);
+
+    hal_debug_uart_set(frame->code, frame->pos - frame->code);
+    hal_debug_uart_set(frame->pos, 0);
+    hal_debug_uart_commit();
+
+    HAL_LOCK(sr);
+    mux_sent[frame->channel]++;
+    HAL_UNLOCK(sr);
+}
+
+/*******************************************************************************
+ * \brief   Send bytes on a channel of the debug UART
+ *
+ *          The bytes are cut in frames of MUX_PAYLOAD_MAX, each of them
+ *          encoded straight into the transmit ring, see mux_open(). The
+ *          bytes after a dropped frame are dropped as well. Safe from ISRs
+ *          and before the scheduler starts.
+ *
+ * \param unsigned char     Channel, MUX_CHANNEL_xxx
+ * \param const char *      Bytes to send, a message of a message channel
+ * \param unsigned int      Number of bytes
+ * \return unsigned int     Number of bytes queued
+ ******************************************************************************/
+unsigned int mux_write( unsigned char channel, const char *buf, unsigned int len )
+{
+    mux_frame_t frame;
+    unsigned int chunk;
+    unsigned int i;
+    unsigned int sent = 0;
+
+    while (len) {
+        chunk = (len > MUX_PAYLOAD_MAX) ? MUX_PAYLOAD_MAX : len;
+
+        if (!mux_open(&frame, channel, chunk)) break;
+
+        frame.crc = crc16(frame.crc, buf, chunk);
+        for (i = 0; i < chunk; i++)
+            mux_encode(&frame, buf[i]);
+
+        mux_close(&frame);
+
+        buf += chunk;
+        len -= chunk;
+        sent += chunk;
+    }
+
+    return sent;
+}
+
+/*******************************************************************************
+ * \brief   Get the number of frames sent and dropped on a channel
+ *
+ * \param unsigned char     Channel, MUX_CHANNEL_xxx
+ * \param unsigned long *   Set to the number of frames dropped
+ * \return unsigned long    Number of frames sent
+ ******************************************************************************/
+unsigned long mux_frames( unsigned char channel, unsigned long *dropped )
+{
+    unsigned long sent;
+    unsigned int sr;
+
+    HAL_LOCK(sr);
+    sent = mux_sent[channel];
+    *dropped = mux_dropped[channel];
+    HAL_UNLOCK(sr);
+
+    return sent;
+}
+
+#endif /* CONFIG_DEBUG_UART_MUX */
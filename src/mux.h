@@ -0,0 +1,56 @@
+#ifndef MUX_H
+#define MUX_H
+
+#include <stdint.h>
+
+#include "config.h"
+
+
+/*******************************************************************************
+ * Macros
+ ******************************************************************************/
+
+// Channels multiplexed on the debug UART, split by tools/muxdemux.py. The
+// streams are cut in frames anywhere, a message must fit in one frame.
+#define MUX_CHANNEL_TEXT    ( 0 )   // Stream, slog() lines
+#define MUX_CHANNEL_TRACE   ( 1 )   // Messages, binary log records
+#define MUX_CHANNEL_RPC     ( 2 )   // Stream, shell output
+#define MUX_CHANNEL_BULK    ( 3 )   // Stream, data dumps
+#define MUX_CHANNELS        ( 4 )
+
+// Largest payload of a frame, a whole log line with its header and EOL so
+// that it is sent as one frame, see LOG_LINE_MAX
+#define MUX_PAYLOAD_MAX     ( 122 )
+
+// Frame on the UART: COBS encoding of the channel, the payload and the
+// CRC-16 of both (little endian), then a 0 delimiter. COBS adds one byte.
+#define MUX_FRAME_SIZE(_len)    ( 1 + 1 + ( _len ) + 2 + 1 )
+#define MUX_FRAME_MAX           MUX_FRAME_SIZE( MUX_PAYLOAD_MAX )
+
+/*******************************************************************************
+ * Types
+ ******************************************************************************/
+
+// Frame encoded in place in the UART transmit ring, see mux_open()
+typedef struct {
+    unsigned int pos;           // Offset of the next byte in the ring
+    unsigned int code;          // Offset of the COBS code of the current block
+    uint16_t crc;               // CRC-16 of the bytes encoded so far
+    unsigned char channel;      // MUX_CHANNEL_xxx
+} mux_frame_t;
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+
+#ifdef CONFIG_DEBUG_UART_MUX
+
+unsigned int mux_write( unsigned char channel, const char *buf, unsigned int len );
+int mux_open( mux_frame_t *frame, unsigned char channel, unsigned int len );
+void mux_putc( mux_frame_t *frame, char c );
+void mux_close( mux_frame_t *frame );
+unsigned long mux_frames( unsigned char channel, unsigned long *dropped );
+
+#endif /* CONFIG_DEBUG_UART_MUX */
+
+#endif /* MUX_H */
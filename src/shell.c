@@ -0,0 +1,519 @@
+#include <msp430.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "hal/clock.h"
+#include "hal/power.h"
+#include "hal/timestamp.h"
+#include "hal/uart.h"
+#include "utils/vuprintf.h"
+#include "log.h"
+#include "mux.h"
+#include "shell.h"
+
+
+#ifdef CONFIG_SHELL
+
+// Shell task stack, in words
+#define SHELL_STACK_SIZE    ( configMINIMAL_STACK_SIZE + 80 )
+
+// Most tasks listed by the "tasks" and "stats" commands
+#define SHELL_TASKS_MAX     ( 8 )
+
+// Registered commands, the built-in ones last
+static shell_command_t *shell_commands;
+
+// Line being received
+static char shell_line[SHELL_LINE_MAX];
+static unsigned char shell_len;
+
+// Output line of shell_printf()
+static char shell_out[SHELL_OUT_MAX];
+
+// Task states of the "tasks" and "stats" commands
+static TaskStatus_t shell_tasks[SHELL_TASKS_MAX];
+
+
+/*******************************************************************************
+ * \brief   Print formatted text on the debug UART
+ *
+ *          The text is formatted at once and queued in one piece, it is cut
+ *          at SHELL_OUT_MAX characters. Only for the shell task.
+ *
+ * \param char *    Format string, see vuprintf_sink()
+ * \param ...       Argument list
+ * \return void
+ ******************************************************************************/
+void shell_printf( const char *fmt, ... )
+{
+    unsigned int len;
+
+    va_list va;
+    va_start(va,fmt);
+    len = vsnuprintf(shell_out, sizeof(shell_out), fmt, va);
+    va_end(va);
+
+#ifdef CONFIG_DEBUG_UART_MUX
+    mux_write(MUX_CHANNEL_RPC, shell_out, len);
+#else
+    (void) len;
+    hal_debug_uart_write(shell_out);
+#endif
+}
+
+/*******************************************************************************
+ * \brief   Parse a number, hexadecimal with a 0x prefix or decimal
+ *
+ * \param const char *      Word
+ * \param unsigned long *   Set to the value
+ * \return int              0 if the word is not a number
+ ******************************************************************************/
+static int shell_number( const char *s, unsigned long *value )
+{
+    unsigned int base = 10;
+    unsigned int digit;
+
+    if (s[0] == '0' && s[1] == 'x') {
+        base = 16;
+        s += 2;
+    }
+
+    if (!*s) return 0;
+
+    for (*value = 0; *s; s++) {
+        if (*s >= '0' && *s <= '9')
+            digit = *s - '0';
+        else if ((*s | 0x20) >= 'a' && (*s | 0x20) <= 'f')
+            digit = (*s | 0x20) - 'a' + 10;
+        else
+            return 0;
+
+        if (digit >= base) return 0;
+
+        *value = *value * base + digit;
+    }
+
+    return 1;
+}
+
+/*******************************************************************************
+ * \brief   Add a command to the shell
+ *
+ *          Commands registered last are looked up first, one can override a
+ *          built-in command.
+ *
+ * \param shell_command_t *     Command, must stay valid
+ * \return void
+ ******************************************************************************/
+void shell_register( shell_command_t *command )
+{
+    taskENTER_CRITICAL();
+    command->next = shell_commands;
+    shell_commands = command;
+    taskEXIT_CRITICAL();
+}
+
+/*******************************************************************************
+ * \brief   Get the states of the tasks
+ *
+ * \param uint32_t *            Set to the total run time
+ * \return UBaseType_t          Number of tasks, 0 when there are more than
+ *                              SHELL_TASKS_MAX
+ ******************************************************************************/
+static UBaseType_t shell_get_tasks( uint32_t *total )
+{
+    UBaseType_t count = uxTaskGetSystemState(shell_tasks, SHELL_TASKS_MAX, total);
+
+    if (!count) shell_printf("more than %u tasks\r\n", SHELL_TASKS_MAX);
+
+    return count;
+}
+
+/*******************************************************************************
+ * \brief   Print the name of a task in a 10 character column
+ *
+ * \param TaskStatus_t *    State of the task
+ * \return void
+ ******************************************************************************/
+static void shell_print_task_name( const TaskStatus_t *task )
+{
+#if configUSE_COMPACT_TCB == 1
+    // Only the hash of the name is kept
+    shell_printf("%x      ", task->usTaskNameHash);
+#else
+    shell_printf("%-10s", task->pcTaskName);
+#endif
+}
+
+/*******************************************************************************
+ * \brief   "help" command, list the commands
+ *
+ * \param int       Number of words
+ * \param char *[]  Words of the command line
+ * \return void
+ ******************************************************************************/
+static void shell_help( int argc, char *argv[] )
+{
+    shell_command_t *command;
+
+    (void) argc;
+    (void) argv;
+
+    for (command = shell_commands; command; command = command->next)
+        shell_printf("%-8s%s\r\n", command->name, command->help);
+}
+
+/*******************************************************************************
+ * \brief   "tasks" command, list the tasks with their state and free stack
+ *
+ *          States are X running, R ready, B blocked, S suspended, D deleted.
+ *
+ * \param int       Number of words
+ * \param char *[]  Words of the command line
+ * \return void
+ ******************************************************************************/
+static void shell_list_tasks( int argc, char *argv[] )
+{
+    UBaseType_t count;
+    UBaseType_t i;
+    uint32_t total;
+
+    (void) argc;
+    (void) argv;
+
+    count = shell_get_tasks(&total);
+
+    shell_printf("name      state prio stack\r\n");
+    for (i = 0; i < count; i++) {
+        shell_print_task_name(&shell_tasks[i]);
+        shell_printf(" %c     %4u %5u\r\n",
+                     "XRBSD"[shell_tasks[i].eCurrentState],
+                     (unsigned int) shell_tasks[i].uxCurrentPriority,
+                     (unsigned int) shell_tasks[i].usStackHighWaterMark);
+    }
+}
+
+/*******************************************************************************
+ * \brief   "heap" command, print the free FreeRTOS heap
+ *
+ * \param int       Number of words
+ * \param char *[]  Words of the command line
+ * \return void
+ ******************************************************************************/
+static void shell_heap( int argc, char *argv[] )
+{
+    (void) argc;
+    (void) argv;
+
+    shell_printf("%u of %u bytes free\r\n",
+                 (unsigned int) xPortGetFreeHeapSize(),
+                 (unsigned int) configTOTAL_HEAP_SIZE);
+}
+
+#if configGENERATE_RUN_TIME_STATS == 1
+/*******************************************************************************
+ * \brief   "stats" command, print the run time of each task
+ *
+ * \param int       Number of words
+ * \param char *[]  Words of the command line
+ * \return void
+ ******************************************************************************/
+static void shell_stats( int argc, char *argv[] )
+{
+    UBaseType_t count;
+    UBaseType_t i;
+    uint32_t total;
+    uint32_t run;
+
+    (void) argc;
+    (void) argv;
+
+    count = shell_get_tasks(&total);
+
+    // Per thousand of the total, rounded down
+    total /= 1000;
+    if (!total) total = 1;
+
+    shell_printf("name      seconds       %%\r\n");
+    for (i = 0; i < count; i++) {
+        run = shell_tasks[i].ulRunTimeCounter;
+        shell_print_task_name(&shell_tasks[i]);
+        shell_printf(" %7n.%03u %5.1q\r\n",
+                     run / HAL_TIMESTAMP_HZ,
+                     (unsigned int) ((run % HAL_TIMESTAMP_HZ) * 1000 / HAL_TIMESTAMP_HZ),
+                     (int) (run / total));
+    }
+}
+#endif
+
+#ifdef CONFIG_DEBUG_UART_MUX
+/*******************************************************************************
+ * \brief   "mux" command, print the frames sent and dropped on each channel
+ *
+ * \param int       Number of words
+ * \param char *[]  Words of the command line
+ * \return void
+ ******************************************************************************/
+static void shell_mux( int argc, char *argv[] )
+{
+    static const char * const names[MUX_CHANNELS] = { "text", "trace", "rpc", "bulk" };
+    unsigned long sent;
+    unsigned long dropped;
+    unsigned char i;
+
+    (void) argc;
+    (void) argv;
+
+    for (i = 0; i < MUX_CHANNELS; i++) {
+        sent = mux_frames(i, &dropped);
+        shell_printf("%-6s%n sent, %n dropped\r\n", names[i], sent, dropped);
+    }
+}
+
+/*******************************************************************************
+ * \brief   "dump" command, send memory on the bulk channel
+ *
+ * \param int       Number of words
+ * \param char *[]  Words of the command line
+ * \return void
+ ******************************************************************************/
+static void shell_dump( int argc, char *argv[] )
+{
+    unsigned long address;
+    unsigned long len;
+
+    if (argc != 3 || !shell_number(argv[1], &address) || !shell_number(argv[2], &len)) {
+        shell_printf("dump <address> <length>\r\n");
+        return;
+    }
+
+    len = mux_write(MUX_CHANNEL_BULK, (const char *) (uintptr_t) address, (unsigned int) len);
+    shell_printf("%n bytes sent\r\n", len);
+}
+#endif
+
+#ifdef CONFIG_LOGGING
+/*******************************************************************************
+ * \brief   "log" command, print or set the most verbose log level sent
+ *
+ * \param int       Number of words
+ * \param char *[]  Words of the command line
+ * \return void
+ ******************************************************************************/
+static void shell_log( int argc, char *argv[] )
+{
+    unsigned long level;
+
+    if (argc > 1) {
+        if (!shell_number(argv[1], &level) || level > LOG_LEVEL_TRACE) {
+            shell_printf("level 0 to %u\r\n", LOG_LEVEL_TRACE);
+            return;
+        }
+        slog_level = level;
+    }
+
+    shell_printf("log level %u\r\n", slog_level);
+}
+#endif
+
+/*******************************************************************************
+ * \brief   Frequency of a clock source of the UCS
+ *
+ * \param unsigned int      SELx value of UCSCTL4
+ * \return unsigned long    Frequency in Hz, 0 if unknown
+ ******************************************************************************/
+static unsigned long shell_clock_source_hz( unsigned int sel )
+{
+    // f_DCOCLKDIV = (N + 1) * f_FLLREFCLK / n, from XT1, see ti_hal_init_fll()
+    unsigned long dcoclkdiv = ((UCSCTL2 & 0x3ff) + 1UL) * CONFIG_XT1_CLOCK_HZ;
+    unsigned int refdiv = UCSCTL3 & 7;
+
+    // FLLREFDIV divides by 1, 2, 4, 8, 12 or 16
+    dcoclkdiv /= (refdiv < 4) ? (1u << refdiv) : (refdiv - 1) * 4;
+
+    switch (sel) {
+        case 0: return CONFIG_XT1_CLOCK_HZ;                         // XT1CLK
+        case 1: return 10000;                                       // VLOCLK
+        case 2: return 32768;                                       // REFOCLK
+        case 3: return dcoclkdiv << ((UCSCTL2 >> 12) & 7);          // DCOCLK
+        case 4: return dcoclkdiv;                                   // DCOCLKDIV
+        default: return 0;                                          // XT2CLK
+    }
+}
+
+/*******************************************************************************
+ * \brief   "clock" command, print the clock frequencies and the core voltage,
+ *          or change the CPU frequency
+ *
+ *          The frequencies are computed from the UCS settings, with the FLL
+ *          locked.
+ *
+ * \param int       Number of words
+ * \param char *[]  Words of the command line
+ * \return void
+ ******************************************************************************/
+static void shell_clock( int argc, char *argv[] )
+{
+    unsigned int sel;
+    unsigned int div;
+    unsigned long hz;
+
+    if (argc > 1) {
+        if (!shell_number(argv[1], &hz)) {
+            shell_printf("clock [frequency in Hz]\r\n");
+            return;
+        }
+        if (!hal_clock_set(hz)) shell_printf("core voltage not raised\r\n");
+    }
+
+    sel = UCSCTL4;
+    div = UCSCTL5;
+
+    // SELM, SELS and SELA are bits 0, 4 and 8 of UCSCTL4, DIVM, DIVS and
+    // DIVA the same bits of UCSCTL5
+    shell_printf("mclk %n Hz\r\n", shell_clock_source_hz(sel & 7) >> (div & 7));
+    shell_printf("smclk %n Hz\r\n", shell_clock_source_hz((sel >> 4) & 7) >> ((div >> 4) & 7));
+    shell_printf("aclk %n Hz\r\n", shell_clock_source_hz((sel >> 8) & 7) >> ((div >> 8) & 7));
+    shell_printf("vcore %u, dcorsel %u\r\n", PMMCTL0 & PMMCOREV_3, (UCSCTL1 >> 4) & 7);
+    shell_printf("uptime %n s\r\n", hal_timestamp() / HAL_TIMESTAMP_HZ);
+}
+
+/*******************************************************************************
+ * \brief   "power" command, print the low power modes entered and left by
+ *          the idle task
+ *
+ * \param int       Number of words
+ * \param char *[]  Words of the command line
+ * \return void
+ ******************************************************************************/
+static void shell_power( int argc, char *argv[] )
+{
+    static const char * const names[HAL_POWER_MODES] = { "active", "lpm0", "lpm1", "lpm3", "lpm4" };
+    unsigned long entries;
+    unsigned long exits;
+    unsigned char i;
+
+    (void) argc;
+    (void) argv;
+
+    for (i = 0; i < HAL_POWER_MODES; i++) {
+        entries = hal_power_count(i, &exits);
+        shell_printf("%-7s%n entered, %n left\r\n", names[i], entries, exits);
+    }
+
+    shell_printf("idle mode %s\r\n", names[hal_power_mode()]);
+}
+
+/*******************************************************************************
+ * \brief   Split a command line into words and run its command
+ *
+ * \param char *    Line, terminated, modified in place
+ * \return void
+ ******************************************************************************/
+static void shell_execute( char *line )
+{
+    char *argv[SHELL_ARGS_MAX];
+    int argc = 0;
+    shell_command_t *command;
+
+    while (*line && argc < SHELL_ARGS_MAX) {
+        // Skip the spaces, then end the word after its last character
+        while (*line == ' ') line++;
+        if (!*line) break;
+
+        argv[argc++] = line;
+        while (*line && *line != ' ') line++;
+        if (*line) *line++ = 0;
+    }
+
+    if (!argc) return;
+
+    for (command = shell_commands; command; command = command->next) {
+        if (strcmp(command->name, argv[0]) == 0) {
+            command->run(argc, argv);
+            return;
+        }
+    }
+
+    shell_printf("%s: unknown command, see help\r\n", argv[0]);
+}
+
+/*******************************************************************************
+ * \brief   Shell task, runs the command lines received on the debug UART
+ *
+ *          The task sleeps until the RX interrupt receives the end of a line.
+ *          The line is echoed when it is run.
+ *
+ * \param void *    Unused
+ * \return void
+ ******************************************************************************/
+static void shell_task( void *params )
+{
+    char c;
+
+    (void) params;
+
+    for (;;) {
+        hal_debug_uart_wait_rx();
+
+        while (hal_debug_uart_read(&c, 1)) {
+            if (c == '\r' || c == '\n') {
+                if (!shell_len) continue;
+
+                shell_line[shell_len] = 0;
+                shell_len = 0;
+
+                shell_printf("> %s\r\n", shell_line);
+                shell_execute(shell_line);
+            } else if (c == '\b' || c == 0x7f) {
+                if (shell_len) shell_len--;
+            } else if (shell_len < SHELL_LINE_MAX - 1) {
+                shell_line[shell_len++] = c;
+            }
+        }
+    }
+}
+
+/*******************************************************************************
+ * \brief   Register the built-in commands and create the shell task
+ *
+ * \param void
+ * \return void
+ ******************************************************************************/
+void shell_init( void )
+{
+    static shell_command_t builtins[] = {
+        { "help",   "list the commands",                    shell_help,         NULL },
+        { "tasks",  "list the tasks, state and free stack", shell_list_tasks,   NULL },
+        { "heap",   "free heap",                            shell_heap,         NULL },
+#if configGENERATE_RUN_TIME_STATS == 1
+        { "stats",  "run time of the tasks",                shell_stats,        NULL },
+#endif
+#ifdef CONFIG_LOGGING
+        { "log",    "[level] print or set the log level",   shell_log,          NULL },
+#endif
+        { "clock",  "[hz] clock frequencies, core voltage", shell_clock,        NULL },
+        { "power",  "low power modes entered and left",     shell_power,        NULL },
+#ifdef CONFIG_DEBUG_UART_MUX
+        { "mux",    "frames sent and dropped per channel",  shell_mux,          NULL },
+        { "dump",   "<address> <length> send memory",       shell_dump,         NULL },
+#endif
+    };
+    unsigned int i;
+
+#ifndef CONFIG_LOGGING
+    // Otherwise set up by enable_logging()
+    hal_init_debug_uart();
+#endif
+
+    // Registered backwards, so that help lists them in order
+    for (i = sizeof(builtins) / sizeof(builtins[0]); i > 0; i--)
+        shell_register(&builtins[i - 1]);
+
+    xTaskCreate(shell_task, "shell", SHELL_STACK_SIZE, NULL, tskIDLE_PRIORITY + 1, NULL);
+}
+
+#endif /* CONFIG_SHELL */
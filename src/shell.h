@@ -0,0 +1,44 @@
+#ifndef SHELL_H
+#define SHELL_H
+
+#include "config.h"
+
+
+/*******************************************************************************
+ * Macros
+ ******************************************************************************/
+
+// Longest command line, the end of longer lines is ignored
+#define SHELL_LINE_MAX      ( 64 )
+
+// Most words of a command line, the command name included
+#define SHELL_ARGS_MAX      ( 6 )
+
+// Longest line output by shell_printf()
+#define SHELL_OUT_MAX       ( 80 )
+
+/*******************************************************************************
+ * Types
+ ******************************************************************************/
+
+// Shell command, allocated by the caller and linked by shell_register()
+typedef struct shell_command {
+    const char *name;                       // Word that runs the command
+    const char *help;                       // One line description
+    void (*run) (int argc, char *argv[]);   // Called with the words of the line
+    struct shell_command *next;             // Next registered command
+} shell_command_t;
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+
+#ifdef CONFIG_SHELL
+
+void shell_init( void );
+void shell_register( shell_command_t *command );
+void shell_printf( const char *fmt, ... );
+
+#endif /* CONFIG_SHELL */
+
+#endif /* SHELL_H */
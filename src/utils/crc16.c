@@ -0,0 +1,31 @@
+#include "crc16.h"
+
+
+// CRC of each 4 bit value, two lookups per byte keep the table in 32 bytes
+static const uint16_t crc16_nibble[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+    0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef,
+};
+
+
+/*******************************************************************************
+ * \brief   Update a CRC-16/CCITT-FALSE with bytes
+ *
+ *          Start from CRC16_INIT, the CRC of "123456789" is 0x29b1.
+ *
+ * \param uint16_t          CRC of the previous bytes
+ * \param const void *      Bytes
+ * \param unsigned int      Number of bytes
+ * \return uint16_t         CRC including the bytes
+ ******************************************************************************/
+uint16_t crc16(uint16_t crc, const void *buf, unsigned int len)
+{
+    const unsigned char *p = buf;
+
+    while (len--) {
+        crc = (crc << 4) ^ crc16_nibble[(crc >> 12) ^ (*p >> 4)];
+        crc = (crc << 4) ^ crc16_nibble[(crc >> 12) ^ (*p++ & 15)];
+    }
+
+    return crc;
+}
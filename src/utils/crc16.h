@@ -0,0 +1,22 @@
+#ifndef CRC16_H
+#define CRC16_H
+
+#include <stdint.h>
+
+#include "config.h"
+
+
+/*******************************************************************************
+ * Macros
+ ******************************************************************************/
+
+// Initial value of a CRC-16/CCITT-FALSE, polynomial 0x1021
+#define CRC16_INIT          ( 0xffff )
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+
+uint16_t crc16(uint16_t crc, const void *buf, unsigned int len);
+
+#endif /* CRC16_H */
@@ -14,10 +14,12 @@
  ******************************************************************************/
 
 #include <stdarg.h>
+#include <stddef.h>
 
 #include "vuprintf.h"
 
 
+#ifndef __MSP430__
 static const unsigned long dv[] = {
 //  4294967296      // 32 bit unsigned max
     1000000000,     // +0
@@ -32,25 +34,136 @@ static const unsigned long dv[] = {
             10,     // +8
              1,     // +9
 };
+#endif
 
 
-static void sputchar(char **str, unsigned c) {
-    *(*str)++ = c;
+// Output of the formatter, the characters past the bound are discarded
+typedef struct {
+    uprintf_putc_t putc;
+    void *ctx;
+    unsigned int left;
+} sink_t;
+
+// Conversion flags, set only when the conversion has any
+#define FMT_LEFT        ( 1 )       // '-' left justify in the field
+#define FMT_ZERO        ( 2 )       // '0' pad numbers with zeros
+#define FMT_WIDTH       ( 4 )       // field width given
+#define FMT_PREC        ( 8 )       // '.' precision given
+#define FMT_LONG        ( 16 )      // 'l' before x or q, 32 bit argument
+
+// Longest padded field, "-0.4294967295" plus a spare
+#define FIELD_MAX       ( 14 )
+
+
+static void sputchar(sink_t *str, unsigned c) {
+    if(str->left) {
+        str->left--;
+        str->putc(str->ctx, c);
+    }
 }
 
-static void sputstr(char **str, char *s) {
-    while(*s) sputchar(str, *s++);
+static void sputstr(sink_t *str, const char *s) {
+    while(*s && str->left) sputchar(str, *s++);
 }
 
-static void sputhex(char **str, unsigned n)
+static void sputbuf(void *ctx, char c) {
+    char **str = ctx;
+    *(*str)++ = c;
+}
+
+static void sputhex(sink_t *str, unsigned n)
 {
     static const char hex[16] = { '0','1','2','3','4','5','6','7','8','9','a','b','c','d','e','f'};
     sputchar(str, hex[n & 15]);
 }
 
+// Output the 4 digits of a 16 bit value, the leading zeros only when lead is
+// set, return whether a digit has been output
+static int sputhex16(sink_t *str, unsigned x, int lead)
+{
+    int i;
 
-static void sxtoa(char **str, unsigned long x, const unsigned long *dp)
+    for(i = 4; i; i--) {
+        // Rotate the next digit in the low nibble
+        x = (x << 4) | ((x >> 12) & 15);
+        if(lead || (x & 15)) lead = 1, sputhex(str, x);
+    }
+    return lead;
+}
+
+// Output len characters padded to the field width
+static void sputfield(sink_t *str, const char *s, unsigned int len, unsigned int width, unsigned char flags)
 {
+    unsigned int pad = (width > len) ? width - len : 0;
+    char c = ' ';
+
+    if(!(flags & FMT_LEFT)) {
+        if(flags & FMT_ZERO) {
+            // The zeros go after the sign
+            if(len && *s == '-') sputchar(str, *s++), len--;
+            c = '0';
+        }
+        for(; pad; pad--) sputchar(str, c);
+    }
+
+    while(len--) sputchar(str, *s++);
+
+    for(; pad; pad--) sputchar(str, ' ');
+}
+
+#ifdef __MSP430__
+
+/*******************************************************************************
+ * \brief   Convert to decimal with the DADD instruction (double dabble)
+ *
+ *          The bits are shifted out of the value from the most significant
+ *          one, each into the carry, and the BCD result is doubled with the
+ *          carry added by DADD. That is 7 one or two cycle instructions per
+ *          bit, with no division and no compare against powers of ten.
+ *
+ * \param sink_t *          Output
+ * \param unsigned long     Value to convert
+ * \param unsigned int      Number of significant bits of the value, 16 or 32
+ * \return void
+ ******************************************************************************/
+static void sxtoa(sink_t *str, unsigned long x, unsigned int bits)
+{
+    unsigned int lo = x;
+    unsigned int hi = x >> 16;
+    unsigned int bcd[3] = { 0, 0, 0 };
+    int i;
+
+    // A 16 bit value is shifted out of the high word
+    if(bits == 16) hi = lo, lo = 0;
+
+    __asm__ (
+        "1:                     \n\t"
+        "rla    %[lo]           \n\t"
+        "rlc    %[hi]           \n\t"
+        "dadd   %[b0], %[b0]    \n\t"
+        "dadd   %[b1], %[b1]    \n\t"
+        "dadd   %[b2], %[b2]    \n\t"
+        "dec    %[n]            \n\t"
+        "jnz    1b              \n\t"
+        : [lo] "+r" (lo), [hi] "+r" (hi),
+          [b0] "+r" (bcd[0]), [b1] "+r" (bcd[1]), [b2] "+r" (bcd[2]),
+          [n] "+r" (bits)
+        :
+        : "cc");
+
+    // Output the digits from the most significant non zero one
+    for(i = 11; i > 0; i--)
+        if((bcd[i >> 2] >> ((i & 3) << 2)) & 15) break;
+
+    for(; i >= 0; i--)
+        sputchar(str, '0' + ((bcd[i >> 2] >> ((i & 3) << 2)) & 15));
+}
+
+#else
+
+static void sxtoa(sink_t *str, unsigned long x, unsigned int bits)
+{
+    const unsigned long *dp = (bits == 16) ? dv + 5 : dv;
     char c;
     unsigned long d;
     if(x) {
@@ -65,46 +178,264 @@ static void sxtoa(char **str, unsigned long x, const unsigned long *dp)
         sputchar(str, '0');
 }
 
+#endif /* __MSP430__ */
 
-void vuprintf(char *str, const char *format, va_list a)
+// Output a value scaled by 10^prec, with prec digits after the point
+static void sputfixed(sink_t *str, unsigned long x, unsigned int bits, unsigned int prec)
+{
+    char digits[10];
+    char *p = digits;
+    sink_t sink = { sputbuf, &p, sizeof(digits) };
+    unsigned int len;
+
+    sxtoa(&sink, x, bits);
+    len = p - digits;
+    p = digits;
+
+    // Integer part, a single zero when the value is below 1
+    if(len > prec)
+        while(len > prec) sputchar(str, *p++), len--;
+    else
+        sputchar(str, '0');
+
+    if(prec) {
+        sputchar(str, '.');
+        for(; prec > len; prec--) sputchar(str, '0');
+        while(len--) sputchar(str, *p++);
+    }
+}
+
+
+/*******************************************************************************
+ * \brief   Format a string into a sink
+ *
+ *          Conversions are %[-][0][width][.prec]<conv>, with <conv>:
+ *           - s c      string, char, the precision is the longest string
+ *           - i u      16 bit signed, unsigned
+ *           - l n      32 bit signed, unsigned
+ *           - x lx     16 or 32 bit hexadecimal, all the digits without a
+ *                      width, only the significant ones with a width
+ *           - q lq     16 or 32 bit signed fixed point, the integer is
+ *                      output divided by 10^prec, with prec decimals
+ *
+ *          The padded conversions are formatted in a small buffer first,
+ *          the plain ones go straight to the sink. With a plan, the literal
+ *          text is copied up to the next conversion without looking for '%'.
+ *
+ * \param sink_t *                  Output
+ * \param const char *              Format string
+ * \param const uprintf_plan_t *    Conversions of the format, or NULL
+ * \param va_list                   Argument list
+ * \return void
+ ******************************************************************************/
+static void sformat(sink_t *str, const char *format, const uprintf_plan_t *plan, va_list a)
 {
+    sink_t field;
+    sink_t *out = str;
+    char buf[FIELD_MAX];
+    char *p;
+    const char *end;
+    unsigned char flags = 0;
+    unsigned char k = 0;
+    unsigned int width = 0;
+    unsigned int prec = 0;
     char c;
     int i;
     long n;
 
-    while((c = *format++)) {
-        if(c == '%') {
-            switch(c = *format++) {
-                case 's':                       // String
-                    sputstr(&str, va_arg(a, char*));
-                    break;
-                case 'c':                       // Char
-                    sputchar(&str, va_arg(a, unsigned));
-                    break;
-                case 'i':                       // 16 bit Integer
-                case 'u':                       // 16 bit Unsigned
-                    i = va_arg(a, int);
-                    if(c == 'i' && i < 0) i = -i, sputchar(&str, '-');
-                    sxtoa(&str, (unsigned)i, dv + 5);
-                    break;
-                case 'l':                       // 32 bit Long
-                case 'n':                       // 32 bit uNsigned loNg
+    while(str->left) {
+        // Literal text up to the next conversion
+        if(plan) {
+            if(k == plan->count) {
+                sputstr(str, format);
+                break;
+            }
+            end = plan->fmt + plan->pos[k++];
+            while(format != end) sputchar(str, *format++);
+        } else {
+            while((c = *format) != '%') {
+                if(!c || !str->left) return;
+                sputchar(str, c);
+                format++;
+            }
+        }
+
+        format++;
+        c = *format++;
+again:
+        switch(c) {
+            case 's':                       // String
+                p = va_arg(a, char*);
+                if(flags) {
+                    // Strings are padded straight to the output
+                    for(i = 0; p[i] && (!(flags & FMT_PREC) || (unsigned) i < prec); i++);
+                    sputfield(str, p, i, width, flags & ~FMT_ZERO);
+                    out = str;
+                } else
+                    sputstr(str, p);
+                break;
+            case 'c':                       // Char
+                sputchar(out, va_arg(a, unsigned));
+                break;
+            case 'i':                       // 16 bit Integer
+            case 'u':                       // 16 bit Unsigned
+                i = va_arg(a, int);
+                if(c == 'i' && i < 0) i = -i, sputchar(out, '-');
+                sxtoa(out, (unsigned)i, 16);
+                break;
+            case 'l':                       // 32 bit Long
+                if(*format == 'x' || *format == 'q') {
+                    flags |= FMT_LONG;
+                    c = *format++;
+                    goto again;
+                }
+                // fall through
+            case 'n':                       // 32 bit uNsigned loNg
+                n = va_arg(a, long);
+                if(c == 'l' &&  n < 0) n = -n, sputchar(out, '-');
+                sxtoa(out, (unsigned long)n, 32);
+                break;
+            case 'x':                       // 16 or 32 bit heXadecimal
+                // The leading zeros are output without a width
+                i = !(flags & FMT_WIDTH);
+                if(flags & FMT_LONG) {
                     n = va_arg(a, long);
-                    if(c == 'l' &&  n < 0) n = -n, sputchar(&str, '-');
-                    sxtoa(&str, (unsigned long)n, dv);
-                    break;
-                case 'x':                       // 16 bit heXadecimal
-                    i = va_arg(a, int);
-                    sputhex(&str, i >> 12);
-                    sputhex(&str, i >> 8);
-                    sputhex(&str, i >> 4);
-                    sputhex(&str, i);
-                    break;
-                case 0: return;
-                default: goto bad_fmt;
+                    i = sputhex16(out, (unsigned long)n >> 16, i);
+                } else
+                    n = va_arg(a, unsigned);
+                if(!sputhex16(out, n, i)) sputchar(out, '0');
+                break;
+            case 'q':                       // 16 or 32 bit fixed point
+                if(flags & FMT_LONG)
+                    n = va_arg(a, long);
+                else
+                    n = va_arg(a, int);
+                if(n < 0) n = -n, sputchar(out, '-');
+                sputfixed(out, (unsigned long)n, (flags & FMT_LONG) ? 32 : 16, prec);
+                break;
+            case '-':                       // Left justify
+                flags |= FMT_LEFT;
+                c = *format++;
+                goto again;
+            case '.':                       // Precision
+                flags |= FMT_PREC;
+                c = *format++;
+                goto again;
+            case '0':                       // Zero padding
+                if(!(flags & (FMT_WIDTH | FMT_PREC))) {
+                    flags |= FMT_ZERO;
+                    c = *format++;
+                    goto again;
+                }
+                // fall through
+            case '1': case '2': case '3': case '4':
+            case '5': case '6': case '7': case '8': case '9':
+                if(flags & FMT_PREC)
+                    prec = prec * 10 + c - '0';
+                else {
+                    // The conversion goes to the field buffer
+                    width = width * 10 + c - '0';
+                    flags |= FMT_WIDTH;
+                    field.putc = sputbuf;
+                    field.ctx = &p;
+                    field.left = sizeof(buf);
+                    p = buf;
+                    out = &field;
+                }
+                c = *format++;
+                goto again;
+            case 0: return;
+            default:
+                sputchar(out, c);
+                break;
+        }
+
+        // Output the padded field and reset the conversion
+        if(flags) {
+            if(out != str) {
+                sputfield(str, buf, p - buf, width, flags);
+                out = str;
             }
-        } else
-bad_fmt:    sputchar(&str, c);
+            flags = 0;
+            width = 0;
+            prec = 0;
+        }
     }
-    sputchar(&str, 0);
+}
+
+/*******************************************************************************
+ * \brief   Format a string into a character sink
+ *
+ *          See sformat() for the conversions.
+ *
+ * \param uprintf_putc_t    Function called for each character
+ * \param void *            Context passed to the function
+ * \param unsigned int      Maximum number of characters to output
+ * \param const char *      Format string
+ * \param va_list           Argument list
+ * \return unsigned int     Number of characters output
+ ******************************************************************************/
+unsigned int vuprintf_sink(uprintf_putc_t putc, void *ctx, unsigned int max, const char *format, va_list a)
+{
+    sink_t sink = { putc, ctx, max };
+
+    sformat(&sink, format, NULL, a);
+
+    return max - sink.left;
+}
+
+/*******************************************************************************
+ * \brief   Format a string parsed at compile time into a character sink
+ *
+ * \param uprintf_putc_t            Function called for each character
+ * \param void *                    Context passed to the function
+ * \param unsigned int              Maximum number of characters to output
+ * \param const uprintf_plan_t *    Format defined with UPRINTF_PLAN()
+ * \param va_list                   Argument list
+ * \return unsigned int             Number of characters output
+ ******************************************************************************/
+unsigned int vuprintf_plan_sink(uprintf_putc_t putc, void *ctx, unsigned int max, const uprintf_plan_t *plan, va_list a)
+{
+    sink_t sink = { putc, ctx, max };
+
+    sformat(&sink, plan->fmt, plan, a);
+
+    return max - sink.left;
+}
+
+/*******************************************************************************
+ * \brief   Format a string into a buffer, truncated to its size
+ *
+ * \param char *            Buffer, always terminated when size > 0
+ * \param unsigned int      Size of the buffer
+ * \param const char *      Format string
+ * \param va_list           Argument list
+ * \return unsigned int     Length of the string written
+ ******************************************************************************/
+unsigned int vsnuprintf(char *str, unsigned int size, const char *format, va_list a)
+{
+    unsigned int len;
+
+    if(!size) return 0;
+
+    len = vuprintf_sink(sputbuf, &str, size - 1, format, a);
+    *str = 0;
+
+    return len;
+}
+
+/*******************************************************************************
+ * \brief   Format a string into a buffer, without bound
+ *
+ *          Prefer vsnuprintf(), the buffer must hold the whole result.
+ *
+ * \param char *            Buffer
+ * \param const char *      Format string
+ * \param va_list           Argument list
+ * \return void
+ ******************************************************************************/
+void vuprintf(char *str, const char *format, va_list a)
+{
+    vuprintf_sink(sputbuf, &str, (unsigned int) -1, format, a);
+    *str = 0;
 }
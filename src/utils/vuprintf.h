@@ -1,13 +1,153 @@
 #ifndef VUPRINTF_H
 #define VUPRINTF_H
 
+#include <stdarg.h>
+
 #include "config.h"
 
 
+/*******************************************************************************
+ * Macros
+ ******************************************************************************/
+
+// Most conversions of a pre-parsed format
+#define UPRINTF_PLAN_MAX    ( 8 )
+
+// Argument taken by a conversion
+#define UPRINTF_ARG_NONE    ( 0 )       // %% and unknown conversions
+#define UPRINTF_ARG_WORD    ( 1 )       // %c %i %u %x %q
+#define UPRINTF_ARG_LONG    ( 2 )       // %l %n %lx %lq
+#define UPRINTF_ARG_STR     ( 3 )       // %s
+
+// Argument taken by the conversion letter at p
+#define UPRINTF_CONV_ARG(p) \
+    ( __builtin_strspn(p, "ciuxq") ? UPRINTF_ARG_WORD : \
+      __builtin_strspn(p, "ln") ? UPRINTF_ARG_LONG : \
+      __builtin_strspn(p, "s") ? UPRINTF_ARG_STR : UPRINTF_ARG_NONE )
+
+// Argument passed for a value, arguments past the last one are
+// UPRINTF_NO_ARG. An int sized value passed to %l, or a long to %i, is
+// caught: it would shift all the following arguments on the 16 bit ABI.
+#define UPRINTF_NO_ARG      ( ( struct uprintf_no_arg * ) 0 )
+#define UPRINTF_ARG(x) _Generic( ( x ), \
+    struct uprintf_no_arg *: UPRINTF_ARG_NONE, \
+    char *: UPRINTF_ARG_STR, \
+    const char *: UPRINTF_ARG_STR, \
+    float: -1, \
+    double: -1, \
+    default: ( sizeof( x ) > sizeof( int ) ? UPRINTF_ARG_LONG : UPRINTF_ARG_WORD ) )
+
+// Pointer into the format at an offset, kept on its terminator
+#define UPRINTF_AT(f, o)    ( ( f ) + ( ( o ) < UPRINTF_LEN_ ? ( o ) : UPRINTF_LEN_ ) )
+
+// Parse conversion k of the format f, following conversion j:
+//  - P: offset of the '%', the format length when there is none left
+//  - S: offset of the conversion letter, after the flags and the width
+//  - C: UPRINTF_ARG_xxx taken by the conversion
+//  - E: offset after the conversion
+//  - A: number of arguments taken up to the conversion
+#define UPRINTF_STEP(f, k, j) \
+    UPRINTF_P##k##_ = UPRINTF_E##j##_ + __builtin_strcspn( UPRINTF_AT( f, UPRINTF_E##j##_ ), "%" ), \
+    UPRINTF_S##k##_ = UPRINTF_P##k##_ + 1 + __builtin_strspn( UPRINTF_AT( f, UPRINTF_P##k##_ + 1 ), "-.0123456789" ), \
+    UPRINTF_C##k##_ = UPRINTF_CONV_ARG( UPRINTF_AT( f, UPRINTF_S##k##_ ) ), \
+    UPRINTF_E##k##_ = UPRINTF_S##k##_ + 1 + ( __builtin_strspn( UPRINTF_AT( f, UPRINTF_S##k##_ ), "l" ) && \
+                                              __builtin_strspn( UPRINTF_AT( f, UPRINTF_S##k##_ + 1 ), "xq" ) ), \
+    UPRINTF_A##k##_ = UPRINTF_A##j##_ + ( UPRINTF_C##k##_ != UPRINTF_ARG_NONE )
+
+// Argument taken by conversion k must be the one passed
+#define UPRINTF_CHECK(k, j) \
+    _Static_assert( UPRINTF_C##k##_ == UPRINTF_ARG_NONE || UPRINTF_C##k##_ == \
+        ( UPRINTF_A##j##_ == 0 ? UPRINTF_G0_ : UPRINTF_A##j##_ == 1 ? UPRINTF_G1_ : \
+          UPRINTF_A##j##_ == 2 ? UPRINTF_G2_ : UPRINTF_A##j##_ == 3 ? UPRINTF_G3_ : \
+          UPRINTF_A##j##_ == 4 ? UPRINTF_G4_ : UPRINTF_A##j##_ == 5 ? UPRINTF_G5_ : \
+          UPRINTF_A##j##_ == 6 ? UPRINTF_G6_ : UPRINTF_G7_ ), \
+        "format conversion " #k " does not match its argument" )
+
+#define UPRINTF_ARGS_(_, a0, a1, a2, a3, a4, a5, a6, a7, ...) \
+    UPRINTF_G0_ = UPRINTF_ARG( a0 ), UPRINTF_G1_ = UPRINTF_ARG( a1 ), \
+    UPRINTF_G2_ = UPRINTF_ARG( a2 ), UPRINTF_G3_ = UPRINTF_ARG( a3 ), \
+    UPRINTF_G4_ = UPRINTF_ARG( a4 ), UPRINTF_G5_ = UPRINTF_ARG( a5 ), \
+    UPRINTF_G6_ = UPRINTF_ARG( a6 ), UPRINTF_G7_ = UPRINTF_ARG( a7 ), \
+    UPRINTF_N_ = ( UPRINTF_G0_ != UPRINTF_ARG_NONE ) + ( UPRINTF_G1_ != UPRINTF_ARG_NONE ) + \
+                 ( UPRINTF_G2_ != UPRINTF_ARG_NONE ) + ( UPRINTF_G3_ != UPRINTF_ARG_NONE ) + \
+                 ( UPRINTF_G4_ != UPRINTF_ARG_NONE ) + ( UPRINTF_G5_ != UPRINTF_ARG_NONE ) + \
+                 ( UPRINTF_G6_ != UPRINTF_ARG_NONE ) + ( UPRINTF_G7_ != UPRINTF_ARG_NONE ), \
+    UPRINTF_MORE_ = UPRINTF_ARG( UPRINTF_FIRST_( __VA_ARGS__ ) )
+
+#define UPRINTF_FIRST_(a, ...)  a
+
+// Whether conversion k is in the format
+#define UPRINTF_IS_(k)          ( UPRINTF_P##k##_ < UPRINTF_LEN_ )
+
+/*******************************************************************************
+ * \brief   Define a pre-parsed format, checked against its arguments
+ *
+ *          The format must be a string literal, it is parsed by the compiler
+ *          and the offsets of its conversions are stored in ROM along with
+ *          it. A conversion that does not take the argument passed, a
+ *          missing or an extra argument are compile errors.
+ *
+ * \param _name     Name of the uprintf_plan_t defined
+ * \param _fmt      Format string literal
+ * \param ...       Arguments, only their types are looked at
+ ******************************************************************************/
+#define UPRINTF_PLAN(_name, _fmt, ...) \
+    enum { \
+        UPRINTF_LEN_ = sizeof( _fmt ) - 1, \
+        UPRINTF_ARGS_( _, ##__VA_ARGS__, UPRINTF_NO_ARG, UPRINTF_NO_ARG, UPRINTF_NO_ARG, \
+                       UPRINTF_NO_ARG, UPRINTF_NO_ARG, UPRINTF_NO_ARG, UPRINTF_NO_ARG, \
+                       UPRINTF_NO_ARG, UPRINTF_NO_ARG ), \
+        UPRINTF_E__ = 0, \
+        UPRINTF_A__ = 0, \
+        UPRINTF_STEP( _fmt, 0, _ ), UPRINTF_STEP( _fmt, 1, 0 ), \
+        UPRINTF_STEP( _fmt, 2, 1 ), UPRINTF_STEP( _fmt, 3, 2 ), \
+        UPRINTF_STEP( _fmt, 4, 3 ), UPRINTF_STEP( _fmt, 5, 4 ), \
+        UPRINTF_STEP( _fmt, 6, 5 ), UPRINTF_STEP( _fmt, 7, 6 ), \
+    }; \
+    _Static_assert( UPRINTF_LEN_ < 255, "format longer than 254 characters" ); \
+    _Static_assert( UPRINTF_MORE_ == UPRINTF_ARG_NONE, "more than 8 arguments" ); \
+    _Static_assert( UPRINTF_G0_ >= 0 && UPRINTF_G1_ >= 0 && UPRINTF_G2_ >= 0 && UPRINTF_G3_ >= 0 && \
+                    UPRINTF_G4_ >= 0 && UPRINTF_G5_ >= 0 && UPRINTF_G6_ >= 0 && UPRINTF_G7_ >= 0, \
+                    "floating point argument" ); \
+    UPRINTF_CHECK( 0, _ ); UPRINTF_CHECK( 1, 0 ); UPRINTF_CHECK( 2, 1 ); UPRINTF_CHECK( 3, 2 ); \
+    UPRINTF_CHECK( 4, 3 ); UPRINTF_CHECK( 5, 4 ); UPRINTF_CHECK( 6, 5 ); UPRINTF_CHECK( 7, 6 ); \
+    _Static_assert( UPRINTF_A7_ == UPRINTF_N_, "number of arguments and of format conversions differ" ); \
+    _Static_assert( UPRINTF_E7_ + __builtin_strcspn( UPRINTF_AT( _fmt, UPRINTF_E7_ ), "%" ) >= UPRINTF_LEN_, \
+                    "more than 8 format conversions" ); \
+    static const uprintf_plan_t _name = { \
+        _fmt, \
+        UPRINTF_IS_( 0 ) + UPRINTF_IS_( 1 ) + UPRINTF_IS_( 2 ) + UPRINTF_IS_( 3 ) + \
+        UPRINTF_IS_( 4 ) + UPRINTF_IS_( 5 ) + UPRINTF_IS_( 6 ) + UPRINTF_IS_( 7 ), \
+        { UPRINTF_IS_( 0 ) * UPRINTF_P0_, UPRINTF_IS_( 1 ) * UPRINTF_P1_, \
+          UPRINTF_IS_( 2 ) * UPRINTF_P2_, UPRINTF_IS_( 3 ) * UPRINTF_P3_, \
+          UPRINTF_IS_( 4 ) * UPRINTF_P4_, UPRINTF_IS_( 5 ) * UPRINTF_P5_, \
+          UPRINTF_IS_( 6 ) * UPRINTF_P6_, UPRINTF_IS_( 7 ) * UPRINTF_P7_ }, \
+        { UPRINTF_C0_, UPRINTF_C1_, UPRINTF_C2_, UPRINTF_C3_, \
+          UPRINTF_C4_, UPRINTF_C5_, UPRINTF_C6_, UPRINTF_C7_ }, \
+    }
+
+/*******************************************************************************
+ * Types
+ ******************************************************************************/
+
+// Output of one formatted character
+typedef void (*uprintf_putc_t) (void *ctx, char c);
+
+// Format parsed at compile time by UPRINTF_PLAN()
+typedef struct {
+    const char *fmt;                        // Format string
+    unsigned char count;                    // Number of conversions
+    unsigned char pos[UPRINTF_PLAN_MAX];    // Offset of the '%' of each conversion
+    unsigned char arg[UPRINTF_PLAN_MAX];    // UPRINTF_ARG_xxx taken by each conversion
+} uprintf_plan_t;
+
 /*******************************************************************************
  * Prototypes
  ******************************************************************************/
 
+unsigned int vuprintf_sink(uprintf_putc_t putc, void *ctx, unsigned int max, const char *format, va_list a);
+unsigned int vuprintf_plan_sink(uprintf_putc_t putc, void *ctx, unsigned int max, const uprintf_plan_t *plan, va_list a);
+unsigned int vsnuprintf(char *str, unsigned int size, const char *format, va_list a);
 void vuprintf(char *str, const char *format, va_list a);
 
 #endif /* VUPRINTF_H */
@@ -0,0 +1,225 @@
+#!/usr/bin/env python3
+"""
+Decode the binary log records sent with CONFIG_LOGGING_BINARY.
+
+The firmware only sends the address of the format string, a timestamp, a
+sequence number, the number of records it lost and the raw arguments, the
+strings are read from the ELF file of the firmware.
+
+    tools/logdecode.py build/firmware.elf /dev/ttyUSB0
+    tools/logdecode.py build/firmware.elf capture.bin
+
+Requires pyelftools (pip install pyelftools), and pyserial to read from a
+serial port.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+from elftools.elf.elffile import ELFFile
+
+
+# Must match src/log.c
+LOG_RECORD_SYNC = 0xa5
+LOG_RECORD_HEADER = 14          # Bytes
+TIMESTAMP_HZ = 32768            # HAL_TIMESTAMP_HZ
+
+
+class Image:
+    """Read-only view of the loadable sections of the ELF file."""
+
+    def __init__(self, path):
+        self.sections = []
+        with open(path, 'rb') as f:
+            elf = ELFFile(f)
+            for section in elf.iter_sections():
+                if section['sh_type'] == 'SHT_PROGBITS' and section['sh_addr']:
+                    self.sections.append((section['sh_addr'], section.data()))
+
+    def string(self, address):
+        for base, data in self.sections:
+            if base <= address < base + len(data):
+                end = data.find(b'\0', address - base)
+                if end < 0:
+                    end = len(data)
+                return data[address - base:end].decode('latin-1')
+        return None
+
+
+# %[-][0][width][.prec]<conv>, see vuprintf_sink()
+CONVERSION = re.compile(r'([-0]*)(\d*)(?:\.(\d*))?(l[xq]|.)?', re.S)
+
+
+def signed16(value):
+    return value - 0x10000 if value & 0x8000 else value
+
+
+def signed32(value):
+    return value - 0x100000000 if value & 0x80000000 else value
+
+
+def fixed(value, prec):
+    """Format an integer scaled by 10^prec like %q."""
+
+    sign = '-' if value < 0 else ''
+    digits = str(abs(value)).rjust(prec + 1, '0')
+    if not prec:
+        return sign + digits
+    return sign + digits[:-prec] + '.' + digits[-prec:]
+
+
+def pad(s, width, flags):
+    """Pad a converted field to its width like vuprintf()."""
+
+    if '-' in flags:
+        return s.ljust(width)
+    if '0' in flags:
+        if s.startswith('-'):
+            return '-' + s[1:].rjust(width - 1, '0')
+        return s.rjust(width, '0')
+    return s.rjust(width)
+
+
+def format_record(image, fmt_address, args):
+    """Format the arguments like vuprintf() does on the target."""
+
+    fmt = image.string(fmt_address)
+    if fmt is None:
+        return '<unknown format 0x%x>' % fmt_address
+
+    out = []
+    i = 0
+    pos = 0
+
+    def word():
+        nonlocal pos
+        if pos + 1 > len(args):
+            raise IndexError
+        pos += 1
+        return args[pos - 1]
+
+    def long():
+        lo = word()
+        return lo | (word() << 16)
+
+    try:
+        while i < len(fmt):
+            c = fmt[i]
+            i += 1
+            if c != '%':
+                out.append(c)
+                continue
+
+            m = CONVERSION.match(fmt, i)
+            i = m.end()
+            flags, width, prec, c = m.groups()
+            if not c:
+                break
+            width = int(width or 0)
+            prec = int(prec or 0) if prec is not None else None
+
+            if c == 's':
+                address = long()
+                s = image.string(address)
+                if s is None:
+                    s = '<ram 0x%x>' % address
+                elif prec is not None:
+                    s = s[:prec]
+                flags = flags.replace('0', '')
+            elif c == 'c':
+                s = chr(word() & 0xff)
+            elif c == 'i':
+                s = str(signed16(word()))
+            elif c == 'u':
+                s = str(word())
+            elif c == 'l':
+                s = str(signed32(long()))
+            elif c == 'n':
+                s = str(long())
+            elif c in ('x', 'lx'):
+                value = long() if c == 'lx' else word()
+                if width:
+                    s = '%x' % value
+                else:
+                    s = '%0*x' % (8 if c == 'lx' else 4, value)
+            elif c in ('q', 'lq'):
+                value = signed32(long()) if c == 'lq' else signed16(word())
+                s = fixed(value, prec or 0)
+            else:
+                s = c
+
+            out.append(pad(s, width, flags))
+    except IndexError:
+        out.append('<truncated>')
+
+    return ''.join(out)
+
+
+def records(stream):
+    """Yield (format address, timestamp, sequence number, records dropped,
+    argument words) from a byte stream."""
+
+    buf = b''
+    while True:
+        chunk = stream.read(64)
+        if not chunk:
+            return
+        buf += chunk
+
+        while len(buf) >= 2:
+            if buf[0] != LOG_RECORD_SYNC:
+                buf = buf[1:]
+                continue
+            length = buf[1]
+            if length < LOG_RECORD_HEADER or length & 1:
+                buf = buf[1:]
+                continue
+            if len(buf) < length:
+                break
+
+            words = struct.unpack('<%dH' % (length // 2), buf[:length])
+            buf = buf[length:]
+
+            fmt_address = words[1] | (words[2] << 16)
+            timestamp = words[3] | (words[4] << 16)
+            yield fmt_address, timestamp, words[5], words[6], words[7:]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n\n')[0])
+    parser.add_argument('elf', help='firmware ELF file')
+    parser.add_argument('input', help='capture file, serial port, or - for stdin')
+    parser.add_argument('-b', '--baud', type=int, default=9600,
+                        help='serial port baud rate (CONFIG_DEBUG_UART_BAUD)')
+    args = parser.parse_args()
+
+    image = Image(args.elf)
+
+    if args.input == '-':
+        stream = sys.stdin.buffer
+    elif args.input.startswith('/dev/'):
+        import serial
+        stream = serial.Serial(args.input, args.baud)
+    else:
+        stream = open(args.input, 'rb')
+
+    expected = None
+    for fmt_address, timestamp, seq, dropped, words in records(stream):
+        # Records lost by the firmware are counted in the next one sent, the
+        # others were lost or corrupted on the link
+        if expected is not None and seq != expected:
+            lost = (seq - expected) & 0xffff
+            if lost != dropped:
+                print('<%d records lost on the link>' % (lost - dropped))
+        expected = (seq + 1) & 0xffff
+
+        note = '(%d dropped) ' % dropped if dropped else ''
+        print('#%-5d %12.6f  %s%s' % (seq, timestamp / TIMESTAMP_HZ, note,
+                                      format_record(image, fmt_address, words)))
+        sys.stdout.flush()
+
+
+if __name__ == '__main__':
+    main()
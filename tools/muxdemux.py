@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+"""
+Split the debug UART frames sent with CONFIG_DEBUG_UART_MUX into one file per
+channel.
+
+Each frame is COBS encoded and ends with a 0 byte, a corrupted frame fails
+its CRC and is skipped without losing the following ones.
+
+    tools/muxdemux.py /dev/ttyUSB0 capture
+    tools/muxdemux.py capture.bin capture
+
+writes capture.text.log, capture.trace.bin, capture.rpc.log and
+capture.bulk.bin. The trace file is read by tools/logdecode.py. With -f the
+text and shell channels are also printed.
+
+Requires pyserial to read from a serial port.
+"""
+
+import argparse
+import struct
+import sys
+
+
+# Must match src/mux.h, (name, file suffix, text)
+CHANNELS = [
+    ('text', 'text.log', True),         # MUX_CHANNEL_TEXT
+    ('trace', 'trace.bin', False),      # MUX_CHANNEL_TRACE
+    ('rpc', 'rpc.log', True),           # MUX_CHANNEL_RPC
+    ('bulk', 'bulk.bin', False),        # MUX_CHANNEL_BULK
+]
+
+
+def crc16(data, crc=0xffff):
+    """CRC-16/CCITT-FALSE like src/utils/crc16.c."""
+
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021 if crc & 0x8000 else crc << 1) & 0xffff
+    return crc
+
+
+def cobs_decode(data):
+    """Decode a COBS frame without its delimiter, None if malformed."""
+
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code < 0xff and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def frames(stream, stats):
+    """Yield (channel, payload) from a byte stream."""
+
+    buf = b''
+    while True:
+        chunk = stream.read(64)
+        if not chunk:
+            return
+        buf += chunk
+
+        *complete, buf = buf.split(b'\0')
+        for data in complete:
+            if not data:
+                continue
+            frame = cobs_decode(data)
+            if frame is None or len(frame) < 3:
+                stats['bad'] += 1
+                continue
+            body, (crc,) = frame[:-2], struct.unpack('<H', frame[-2:])
+            if crc16(body) != crc or body[0] >= len(CHANNELS):
+                stats['bad'] += 1
+                continue
+            yield body[0], body[1:]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n\n')[0])
+    parser.add_argument('input', help='capture file, serial port, or - for stdin')
+    parser.add_argument('prefix', help='prefix of the output files')
+    parser.add_argument('-b', '--baud', type=int, default=9600,
+                        help='serial port baud rate (CONFIG_DEBUG_UART_BAUD)')
+    parser.add_argument('-f', '--follow', action='store_true',
+                        help='print the text and shell channels')
+    args = parser.parse_args()
+
+    if args.input == '-':
+        stream = sys.stdin.buffer
+    elif args.input.startswith('/dev/'):
+        import serial
+        stream = serial.Serial(args.input, args.baud)
+    else:
+        stream = open(args.input, 'rb')
+
+    outputs = [open('%s.%s' % (args.prefix, suffix), 'wb')
+               for _, suffix, _ in CHANNELS]
+    counts = [0] * len(CHANNELS)
+    stats = {'bad': 0}
+
+    try:
+        for channel, payload in frames(stream, stats):
+            outputs[channel].write(payload)
+            outputs[channel].flush()
+            counts[channel] += 1
+            if args.follow and CHANNELS[channel][2]:
+                sys.stdout.write(payload.decode('latin-1'))
+                sys.stdout.flush()
+    except KeyboardInterrupt:
+        pass
+
+    for (name, _, _), count in zip(CHANNELS, counts):
+        print('%-6s %d frames' % (name, count), file=sys.stderr)
+    print('bad    %d frames' % stats['bad'], file=sys.stderr)
+
+
+if __name__ == '__main__':
+    main()